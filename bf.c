@@ -0,0 +1,193 @@
+#include "monty.h"
+
+/**
+ * Appends an instruction to a Brainfuck program, merging it into the
+ * previous one when both are `+` or both are `>`.
+
+ * @param prog: The program.
+
+ * @param op: The instruction.
+
+ * @param n: Its argument (see bf_op_t).
+ */
+static void bf_emit(bf_prog_t *prog, int op, long n)
+{
+	bf_op_t *ops, *last;
+
+	last = prog->count > 0 ? &prog->ops[prog->count - 1] : NULL;
+	if ((op == '+' || op == '>') && last != NULL && last->op == op)
+	{
+		last->n += n;
+		if (op == '>' && labs(last->n) > prog->reach)
+			prog->reach = labs(last->n);
+		if (last->n == 0)
+			prog->count--;
+		return;
+	}
+	if (prog->count == prog->cap)
+	{
+		ops = realloc(prog->ops, (prog->cap * 2 + 64) * sizeof(*ops));
+		if (ops == NULL)
+			err(4);
+		prog->ops = ops;
+		prog->cap = prog->cap * 2 + 64;
+	}
+	prog->ops[prog->count].op = op;
+	prog->ops[prog->count++].n = n;
+	if (op == '>' && labs(n) > prog->reach)
+		prog->reach = labs(n);
+}
+
+/**
+ * Closes the loop opened at `k`.
+
+ * @param prog: The program.
+
+ * @param k: The index of the `[`.
+
+ * A loop whose body is a single odd `+` only ends once the cell is 0, and
+ * becomes BF_CLEAR; a loop whose body is `>` or `<` becomes a scan for the
+ * next 0 cell on that side.
+ */
+static void bf_close(bf_prog_t *prog, size_t k)
+{
+	bf_op_t *body = &prog->ops[k + 1];
+
+	if (prog->count == k + 2 && body->op == '+' && body->n % 2 != 0)
+	{
+		prog->count = k;
+		bf_emit(prog, BF_CLEAR, 0);
+		return;
+	}
+	if (prog->count == k + 2 && body->op == '>' && labs(body->n) == 1)
+	{
+		prog->count = k;
+		bf_emit(prog, body->n == 1 ? BF_SCAN_R : BF_SCAN_L, 0);
+		return;
+	}
+	prog->ops[k].n = prog->count;
+	bf_emit(prog, ']', k);
+}
+
+/**
+ * Compiles a Brainfuck program.
+
+ * @param src: The source; characters other than `+-<>[].,` are comments.
+
+ * @param len: The length of the source.
+
+ * @param name: The name of the file, for errors.
+
+ * @param prog: Receives the program.
+
+ * While a `[` is open, its argument holds its line number.
+ */
+void bf_compile(char *src, size_t len, char *name, bf_prog_t *prog)
+{
+	size_t i, depth = 0, *open;
+	int line = 1;
+
+	memset(prog, 0, sizeof(*prog));
+	open = malloc((len + 1) * sizeof(*open));
+	if (open == NULL)
+		err(4);
+	for (i = 0; i < len; i++)
+	{
+		if (src[i] == '\n')
+			line++;
+		else if (src[i] == '+' || src[i] == '-')
+			bf_emit(prog, '+', src[i] == '+' ? 1 : -1);
+		else if (src[i] == '>' || src[i] == '<')
+			bf_emit(prog, '>', src[i] == '>' ? 1 : -1);
+		else if (src[i] == '.' || src[i] == ',')
+			bf_emit(prog, src[i], 0);
+		else if (src[i] == '[')
+		{
+			open[depth++] = prog->count;
+			bf_emit(prog, '[', line);
+		}
+		else if (src[i] == ']' && depth > 0)
+			bf_close(prog, open[--depth]);
+		else if (src[i] == ']')
+			err(21, name, line, ']');
+	}
+	if (depth > 0)
+		err(21, name, (int)prog->ops[open[depth - 1]].n, '[');
+	free(open);
+}
+
+/**
+ * Runs a compiled Brainfuck program.
+
+ * @param prog: The program.
+
+ * @param tape: The first cell of the tape, zeroed.
+
+ * @param size: The number of cells.
+
+ * @return: 0 when the program ends, 1 or 2 when a scan runs off the tape
+ * before its first or past its last cell.
+
+ * Nothing checks the moves of the pointer: the tape is surrounded by guard
+ * pages at least as long as the longest move, so the first access out of
+ * the tape faults (see run_bf). Every other instruction accesses the cell,
+ * so the pointer can never cross a guard page unnoticed: `,` writes the
+ * cell back even at the end of the input. A scan starts by reading the
+ * cell, then searches the tape with memchr or memrchr.
+ */
+int bf_exec(bf_prog_t *prog, unsigned char *tape, size_t size)
+{
+	bf_op_t *ops = prog->ops;
+	unsigned char *p = tape, *q;
+	size_t i;
+	int c;
+
+	for (i = 0; i < prog->count; i++)
+	{
+		switch (ops[i].op)
+		{
+			case '+':
+				*p += (unsigned char)ops[i].n;
+				break;
+			case '>':
+				p += ops[i].n;
+				break;
+			case '[':
+				if (*p == 0)
+					i = ops[i].n;
+				break;
+			case ']':
+				if (*p != 0)
+					i = ops[i].n;
+				break;
+			case '.':
+				putc(*p, out_stream);
+				break;
+			case ',':
+				c = getchar();
+				*(volatile unsigned char *)p = c != EOF ?
+					(unsigned char)c : *p;
+				break;
+			case BF_CLEAR:
+				*p = 0;
+				break;
+			case BF_SCAN_R:
+				if (*p == 0)
+					break;
+				q = memchr(p, 0, tape + size - p);
+				if (q == NULL)
+					return (2);
+				p = q;
+				break;
+			case BF_SCAN_L:
+				if (*p == 0)
+					break;
+				q = memrchr(tape, 0, p - tape);
+				if (q == NULL)
+					return (1);
+				p = q;
+				break;
+		}
+	}
+	return (0);
+}
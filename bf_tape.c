@@ -0,0 +1,126 @@
+#include "signals.h"
+#include "monty.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static sigjmp_buf tape_jmp;
+static unsigned char *tape_lo, *tape_cells, *tape_hi;
+
+/**
+ * Handles a fault during a Brainfuck run.
+
+ * @param sig: The signal, SIGSEGV.
+
+ * @param info: Where the fault happened.
+
+ * @param ctx: Unused.
+
+ * A fault in a guard page of the tape jumps back to run_bf with the side of
+ * the tape it is on. Any other fault is a bug: the handler is removed and the
+ * faulting access runs again, this time killing the process.
+ */
+static void tape_fault(int sig, siginfo_t *info, void *ctx)
+{
+	unsigned char *addr = info->si_addr;
+
+	(void)ctx;
+	if (addr >= tape_lo && addr < tape_hi)
+		siglongjmp(tape_jmp, addr < tape_cells ? 1 : 2);
+	signal(sig, SIG_DFL);
+}
+
+/**
+ * Reads and compiles a Brainfuck program.
+
+ * @param file: The path of the program.
+
+ * @param prog: Receives the program.
+ */
+static void bf_load(char *file, bf_prog_t *prog)
+{
+	struct stat st;
+	char *src;
+	int fd;
+
+	fd = open(file, O_RDONLY);
+	if (fd == -1 || fstat(fd, &st) == -1)
+		err(2, file);
+	src = st.st_size == 0 ? NULL
+		: mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (src == MAP_FAILED)
+		err(2, file);
+	bf_compile(src, st.st_size, file, prog);
+	if (src != NULL)
+		munmap(src, st.st_size);
+}
+
+/**
+ * Maps the tape of a Brainfuck run between two guard pages.
+
+ * @param size: The number of cells; rounded up to whole pages.
+
+ * @param reach: The longest move of the pointer by one instruction.
+
+ * @return: The length of the mapping.
+ */
+static size_t tape_map(size_t *size, long reach)
+{
+	size_t page, guard;
+
+	page = sysconf(_SC_PAGESIZE);
+	*size = (*size + page - 1) / page * page;
+	guard = ((size_t)reach + page - 1) / page * page;
+	guard = guard == 0 ? page : guard;
+	tape_lo = mmap(NULL, *size + 2 * guard, PROT_NONE,
+		       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (tape_lo == MAP_FAILED)
+		err(4);
+	tape_cells = tape_lo + guard;
+	tape_hi = tape_cells + *size + guard;
+	if (mprotect(tape_cells, *size, PROT_READ | PROT_WRITE) == -1)
+		err(4);
+	return (*size + 2 * guard);
+}
+
+/**
+ * Runs a Brainfuck program (`--bf`).
+
+ * @param opts: The options; `--tape-size` is the number of cells, rounded
+ * up to whole pages (30000 by default).
+
+ * @return: 0 on success; the program exits on errors.
+
+ * The tape is mapped between two PROT_NONE guard pages at least as long as
+ * the longest move of the pointer, so bf_exec never checks a move: an
+ * access out of the tape faults in a guard page and tape_fault jumps back
+ * here to report it.
+ */
+int run_bf(options_t *opts)
+{
+	static char *side_name[] = {NULL, "before", "past"};
+	struct sigaction sa;
+	size_t size, len;
+	bf_prog_t prog;
+	int side;
+
+	size = opts->tape_size == NULL ? BF_TAPE : parse_size(opts->tape_size);
+	if (size == 0)
+		err(1);
+	bf_load(opts->file, &prog);
+	len = tape_map(&size, prog.reach);
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction = tape_fault;
+	sa.sa_flags = SA_SIGINFO;
+	sigaction(SIGSEGV, &sa, NULL);
+	side = sigsetjmp(tape_jmp, 1);
+	if (side == 0)
+		side = bf_exec(&prog, tape_cells, size);
+	signal(SIGSEGV, SIG_DFL);
+	munmap(tape_lo, len);
+	free(prog.ops);
+	if (side != 0)
+		err(22, opts->file, side_name[side]);
+	return (0);
+}
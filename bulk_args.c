@@ -0,0 +1,89 @@
+#include "monty.h"
+
+/**
+ * Structure describing the arguments of an opcode taking integer arguments.
+
+ * @field f: The handler of the opcode.
+ * @field args: The number of arguments, a negative number when the last
+ * one may be omitted.
+ * @field count: The index of the argument that has a minimum, -1 if none.
+ * @field min: The minimum of that argument.
+ * @field usage: The usage line printed for bad arguments.
+ */
+static const struct
+{
+	op_func f;
+	int args;
+	int count;
+	int min;
+	char *usage;
+} bulk_list[] = {
+	{sum_nodes, 1, 0, 1, "sum count"},
+	{prod_nodes, 1, 0, 1, "prod count"},
+	{rev_nodes, 1, 0, 1, "rev count"},
+	{sort_nodes, -1, 0, 1, "sort [count]"},
+	{addc_nodes, 2, 1, 1, "addc value count"},
+	{mulc_nodes, 2, 1, 1, "mulc value count"},
+	{range_stack, 2, -1, 0, "range first last"},
+	{range_queue, 2, -1, 0, "range first last"},
+	{store_reg, 1, -1, 0, "store register"},
+	{load_stack, 1, -1, 0, "load register"},
+	{load_queue, 1, -1, 0, "load register"},
+	{pick_nodes, 1, 0, 0, "pick index"},
+	{roll_nodes, 1, 0, 0, "roll index"},
+	{NULL, 0, 0, 0, NULL}
+};
+
+/**
+ * Parses the arguments of a bulk opcode into its instruction.
+
+ * @param f: The handler the opcode was resolved to.
+
+ * @param val: The first argument (may be NULL).
+
+ * @param val2: The second argument (may be NULL).
+
+ * @param code: The instruction receiving the arguments in `n` and `n2`.
+
+ * @return: 1 if `f` is a bulk opcode and its arguments are not valid,
+ * 0 otherwise. On failure `n` is set for bad_bulk to find the usage line.
+
+ * The arguments are integers checked like the one of `push`, and must fit
+ * in an int; counts must also be positive and indexes not negative. Register numbers are checked
+ * when the instruction runs.
+ */
+int bulk_args(op_func f, char *val, char *val2, code_t *code)
+{
+	int i, arg[2] = {0, 0};
+
+	for (i = 0; bulk_list[i].f != NULL && bulk_list[i].f != f; i++)
+		;
+	if (bulk_list[i].f == NULL)
+		return (0);
+	if (bulk_list[i].args == -1 && val == NULL)
+		return (0);
+	if (parse_push(val, &arg[0]) ||
+	    (bulk_list[i].args == 2 && parse_push(val2, &arg[1])) ||
+	    (bulk_list[i].count >= 0 &&
+	     arg[bulk_list[i].count] < bulk_list[i].min))
+	{
+		code->n = i;
+		return (1);
+	}
+	code->n = arg[0];
+	code->n2 = arg[1];
+	return (0);
+}
+
+/**
+ * Reports bad arguments of a bulk opcode once execution reaches it.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack (unused).
+
+ * @param ln: The line number of the instruction.
+ */
+void bad_bulk(stack_t **stack, unsigned int ln)
+{
+	(void)stack;
+	err(17, ln, bulk_list[pc->n].usage);
+}
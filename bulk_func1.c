@@ -0,0 +1,148 @@
+#include "monty.h"
+
+/**
+ * Returns a scratch array for the bulk operations.
+
+ * @param n: The number of values it must hold.
+
+ * @return: The array, valid until the next call.
+
+ * The array is kept between instructions and only grows, so a script
+ * running bulk operations in a loop allocates once.
+ */
+unsigned int *bulk_buffer(size_t n)
+{
+	static unsigned int *buf;
+	static size_t size;
+	unsigned int *tmp;
+
+	if (n > size)
+	{
+		tmp = realloc(buf, (n + n / 2 + 64) * sizeof(*buf));
+		if (tmp == NULL)
+			err(4);
+		buf = tmp;
+		size = n + n / 2 + 64;
+	}
+	return (buf);
+}
+
+/**
+ * Copies the values of the top nodes of the stack to the scratch array.
+
+ * @param n: The number of values to copy, 0 for the whole stack. Receives
+ * the number of values copied.
+
+ * @param op: The opcode, for the error message.
+
+ * @return: The values, top first, or NULL if one of them is boxed; the
+ * caller then works on the nodes (see bulk_fold).
+
+ * Exits with `L<n>: can't <op>, stack too short` when the stack holds less
+ * than `n` values.
+ */
+unsigned int *bulk_gather(size_t *n, char *op)
+{
+	unsigned int *v;
+	stack_t *node;
+	size_t i, depth = *n;
+	int tags = TAG_INT;
+
+	if (depth == 0)
+	{
+		for (node = head; node != NULL; node = node->next)
+			depth++;
+	}
+	v = bulk_buffer(depth);
+	for (i = 0, node = head; i < depth && node != NULL; i++)
+	{
+		v[i] = node->n;
+		tags |= node->tag;
+		node = node->next;
+		if (((i + 1) & POOL_WALK) == 0)
+			pool_walk(node);
+	}
+	if (i < depth)
+		more_err(8, pc->ln, op);
+	*n = depth;
+	return (tags == TAG_INT ? v : NULL);
+}
+
+/**
+ * Removes the top nodes of the stack.
+
+ * @param n: The number of nodes to remove; the stack holds at least that many.
+ */
+void bulk_drop(size_t n)
+{
+	stack_t *node;
+
+	for (; n > 0; n--)
+	{
+		node = head;
+		head = head->next;
+		free_node(node);
+	}
+	if (head != NULL)
+		head->prev = NULL;
+}
+
+/**
+ * Replaces the top `count` elements of the stack with their sum.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * The ints are added up in 64 bits, which cannot overflow for less than
+ * 2^32 of them; boxed values are added one by one.
+ */
+void sum_nodes(stack_t **stack, unsigned int line_number)
+{
+	unsigned int *v;
+	size_t n = pc->n;
+
+	(void)stack;
+	(void)line_number;
+	v = bulk_gather(&n, "sum");
+	if (v == NULL || n > 0xffffffffUL)
+	{
+		bulk_fold(n, '+');
+		return;
+	}
+	bulk_drop(n - 1);
+	num_set_long(head, bulk_sum(v, n));
+}
+
+/**
+ * Replaces the top `count` elements of the stack with their product.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * The ints are multiplied in 64 bits with overflow checks; past 64 bits, or
+ * with boxed values, the product is computed one node at a time.
+ */
+void prod_nodes(stack_t **stack, unsigned int line_number)
+{
+	unsigned int *v;
+	size_t n = pc->n, i;
+	long p = 1;
+
+	(void)stack;
+	(void)line_number;
+	v = bulk_gather(&n, "prod");
+	for (i = 0; v != NULL && i < n; i++)
+	{
+		if (__builtin_mul_overflow(p, (int)v[i], &p))
+			break;
+	}
+	if (v == NULL || i < n)
+	{
+		bulk_fold(n, '*');
+		return;
+	}
+	bulk_drop(n - 1);
+	num_set_long(head, p);
+}
@@ -0,0 +1,99 @@
+#include "monty.h"
+
+/**
+ * Copies values back into the top nodes of the stack.
+
+ * @param v: The values, top first.
+
+ * @param n: The number of values; the stack holds at least that many.
+ */
+void bulk_scatter(unsigned int *v, size_t n)
+{
+	stack_t *node;
+	size_t i;
+
+	for (i = 0, node = head; i < n; i++)
+	{
+		node->n = v[i];
+		node = node->next;
+		if (((i + 1) & POOL_WALK) == 0)
+			pool_walk(node);
+	}
+}
+
+/**
+ * Reverses the order of the top `count` elements of the stack.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+ */
+void rev_nodes(stack_t **stack, unsigned int line_number)
+{
+	unsigned int *v;
+	size_t n = pc->n;
+
+	(void)stack;
+	(void)line_number;
+	v = bulk_gather(&n, "rev");
+	if (v == NULL)
+	{
+		bulk_rev_nodes(n);
+		return;
+	}
+	bulk_reverse(v, n);
+	bulk_scatter(v, n);
+}
+
+/**
+ * Adds a constant to each of the top `count` elements of the stack.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * The constant is the first argument of the instruction, the count the second.
+ * When a value is boxed or a result overflows, the nodes are left as they
+ * were and updated one by one instead (see bulk_scale_nodes).
+ */
+void addc_nodes(stack_t **stack, unsigned int line_number)
+{
+	unsigned int *v;
+	size_t n = pc->n2;
+
+	(void)stack;
+	(void)line_number;
+	v = bulk_gather(&n, "addc");
+	if (v == NULL || bulk_scale(v, n, 1, pc->n))
+	{
+		bulk_scale_nodes(n, 1, pc->n);
+		return;
+	}
+	bulk_scatter(v, n);
+}
+
+/**
+ * Multiplies each of the top `count` elements of the stack by a constant.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * The constant is the first argument of the instruction, the count the second.
+ * Overflows are handled as for addc.
+ */
+void mulc_nodes(stack_t **stack, unsigned int line_number)
+{
+	unsigned int *v;
+	size_t n = pc->n2;
+
+	(void)stack;
+	(void)line_number;
+	v = bulk_gather(&n, "mulc");
+	if (v == NULL || bulk_scale(v, n, pc->n, 0))
+	{
+		bulk_scale_nodes(n, pc->n, 0);
+		return;
+	}
+	bulk_scatter(v, n);
+}
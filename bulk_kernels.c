@@ -0,0 +1,155 @@
+#include "monty.h"
+#include <limits.h>
+
+typedef unsigned int bulk_vec __attribute__((vector_size(32)));
+typedef int bulk_half __attribute__((vector_size(16)));
+typedef long bulk_wide __attribute__((vector_size(32)));
+#define BULK_VEC (sizeof(bulk_vec) / sizeof(int))
+
+/*
+ * On x86-64 every kernel is built twice, for AVX2 and for the SSE2 baseline,
+ * and the loader picks one when the program starts. Elsewhere the vectors
+ * are lowered to whatever the target has, down to plain scalar code.
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define BULK_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define BULK_CLONES
+#endif
+
+/**
+ * Adds up an array of values.
+
+ * @param v: The values, ints.
+
+ * @param n: The number of values, less than 2^32.
+
+ * @return: The sum, exact.
+
+ * The ints are widened to 64 bits, half a vector at a time, so the sum
+ * cannot overflow.
+ */
+BULK_CLONES
+long bulk_sum(unsigned int *v, size_t n)
+{
+	bulk_wide acc = {0}, acc2 = {0};
+	bulk_half x, y;
+	long s = 0;
+	size_t i;
+
+	for (i = 0; i + BULK_VEC <= n; i += BULK_VEC)
+	{
+		memcpy(&x, v + i, sizeof(x));
+		memcpy(&y, v + i + BULK_VEC / 2, sizeof(y));
+		acc += __builtin_convertvector(x, bulk_wide);
+		acc2 += __builtin_convertvector(y, bulk_wide);
+	}
+	for (; i < n; i++)
+		s += (int)v[i];
+	acc += acc2;
+	for (i = 0; i < BULK_VEC / 2; i++)
+		s += acc[i];
+	return (s);
+}
+
+/**
+ * Replaces every value of an array with `value * mul + add`.
+
+ * @param v: The values, ints.
+
+ * @param n: The number of values.
+
+ * @param mul: The factor.
+
+ * @param add: The term added after the multiplication.
+
+ * @return: 1 if a result does not fit in an int, 0 otherwise.
+
+ * The results are computed in 64 bits, where they cannot overflow, and
+ * checked against the range of an int before being narrowed back.
+ */
+BULK_CLONES
+int bulk_scale(unsigned int *v, size_t n, int mul, int add)
+{
+	bulk_wide x, over = {0};
+	bulk_half h;
+	long r;
+	size_t i;
+
+	for (i = 0; i + BULK_VEC / 2 <= n; i += BULK_VEC / 2)
+	{
+		memcpy(&h, v + i, sizeof(h));
+		x = __builtin_convertvector(h, bulk_wide) * mul + add;
+		over |= (x < INT_MIN) | (x > INT_MAX);
+		h = __builtin_convertvector(x, bulk_half);
+		memcpy(v + i, &h, sizeof(h));
+	}
+	for (; i < n; i++)
+	{
+		r = (long)(int)v[i] * mul + add;
+		over[0] |= r < INT_MIN || r > INT_MAX;
+		v[i] = (unsigned int)r;
+	}
+	return ((over[0] | over[1] | over[2] | over[3]) != 0);
+}
+
+/**
+ * Fills an array with an arithmetic sequence.
+
+ * @param v: The array.
+
+ * @param n: The number of values to write.
+
+ * @param start: The first value.
+
+ * @param step: The difference between two values.
+ */
+BULK_CLONES
+void bulk_iota(unsigned int *v, size_t n, unsigned int start, unsigned int step)
+{
+	bulk_vec x = {0, 1, 2, 3, 4, 5, 6, 7};
+	size_t i;
+
+	x = x * step + start;
+	for (i = 0; i + BULK_VEC <= n; i += BULK_VEC)
+	{
+		memcpy(v + i, &x, sizeof(x));
+		x += step * (unsigned int)BULK_VEC;
+	}
+	for (; i < n; i++)
+		v[i] = start + step * (unsigned int)i;
+}
+
+/**
+ * Reverses an array in place.
+
+ * @param v: The array.
+
+ * @param n: The number of values.
+
+ * A vector is taken from each end, reversed and stored at the other end,
+ * until the two ends meet.
+ */
+BULK_CLONES
+void bulk_reverse(unsigned int *v, size_t n)
+{
+	bulk_vec a, b, m = {7, 6, 5, 4, 3, 2, 1, 0};
+	size_t i = 0, j = n;
+	unsigned int t;
+
+	for (; j - i >= 2 * BULK_VEC; i += BULK_VEC, j -= BULK_VEC)
+	{
+		memcpy(&a, v + i, sizeof(a));
+		memcpy(&b, v + j - BULK_VEC, sizeof(b));
+		a = __builtin_shuffle(a, m);
+		b = __builtin_shuffle(b, m);
+		memcpy(v + i, &b, sizeof(b));
+		memcpy(v + j - BULK_VEC, &a, sizeof(a));
+	}
+	for (; i + 1 < j; i++)
+	{
+		t = v[i];
+		v[i] = v[--j];
+		v[j] = t;
+	}
+}
@@ -0,0 +1,109 @@
+#include "monty.h"
+
+/**
+ * Links new nodes holding an array of values, in array order.
+
+ * @param v: The values.
+
+ * @param n: The number of values, at least one.
+
+ * @param last: Receives the node of the last value.
+
+ * @return: The node of the first value.
+
+ * The nodes are allocated from the last value to the first, as if the
+ * values had been pushed in that order.
+ */
+static stack_t *bulk_chain(unsigned int *v, size_t n, stack_t **last)
+{
+	stack_t *first = NULL, *node;
+
+	*last = NULL;
+	for (; n > 0; n--)
+	{
+		node = create_node(v[n - 1]);
+		node->next = first;
+		if (first != NULL)
+			first->prev = node;
+		else
+			*last = node;
+		first = node;
+	}
+	return (first);
+}
+
+/**
+ * Counts the values from `first` to `last`, both included.
+
+ * @param first: The first value of the range.
+
+ * @param last: The last value of the range.
+
+ * @return: The number of values.
+ */
+static size_t range_len(int first, int last)
+{
+	if (first <= last)
+		return ((size_t)((long)last - first) + 1);
+	return ((size_t)((long)first - last) + 1);
+}
+
+/**
+ * Pushes every integer from the first argument to the second one on the stack.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * This is the `range` handler of stack regions: the values are pushed in
+ * order, counting up or down, so the second argument ends up on top.
+ */
+void range_stack(stack_t **stack, unsigned int line_number)
+{
+	stack_t *first, *last;
+	unsigned int *v;
+	size_t n = range_len(pc->n, pc->n2);
+
+	(void)stack;
+	(void)line_number;
+	v = bulk_buffer(n);
+	bulk_iota(v, n, pc->n2, pc->n <= pc->n2 ? -1U : 1U);
+	first = bulk_chain(v, n, &last);
+	last->next = head;
+	if (head != NULL)
+		head->prev = last;
+	head = first;
+}
+
+/**
+ * Adds every integer from the first argument to the second one to the queue.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * This is the `range` handler of queue regions: the values are added to the
+ * back in order, so the first argument comes out first. The back of the
+ * queue is only looked for once.
+ */
+void range_queue(stack_t **stack, unsigned int line_number)
+{
+	stack_t *first, *last, *tail;
+	unsigned int *v;
+	size_t n = range_len(pc->n, pc->n2);
+
+	(void)stack;
+	(void)line_number;
+	v = bulk_buffer(n);
+	bulk_iota(v, n, pc->n, pc->n <= pc->n2 ? 1U : -1U);
+	first = bulk_chain(v, n, &last);
+	if (head == NULL)
+	{
+		head = first;
+		return;
+	}
+	for (tail = head; tail->next != NULL; tail = tail->next)
+		;
+	tail->next = first;
+	first->prev = tail;
+}
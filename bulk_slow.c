@@ -0,0 +1,119 @@
+#include "monty.h"
+
+/**
+ * Replaces the top `n` elements of the stack with their sum or product,
+ * one node at a time.
+
+ * @param n: The number of elements; the stack holds at least that many.
+
+ * @param op: '+' or '*'.
+
+ * This is the path of `sum` and `prod` when a value is boxed or the result
+ * does not fit in 64 bits.
+ */
+void bulk_fold(size_t n, int op)
+{
+	for (; n > 1; n--)
+	{
+		num_arith(head->next, head, op);
+		bulk_drop(1);
+	}
+}
+
+/**
+ * Replaces each of the top `n` elements with `value * mul + add`, one node
+ * at a time.
+
+ * @param n: The number of elements; the stack holds at least that many.
+
+ * @param mul: The factor.
+
+ * @param add: The term added after the multiplication.
+ */
+void bulk_scale_nodes(size_t n, int mul, int add)
+{
+	stack_t c, *node;
+	size_t i;
+
+	memset(&c, 0, sizeof(c));
+	for (i = 0, node = head; i < n; i++, node = node->next)
+	{
+		c.n = mul;
+		if (mul != 1)
+			num_arith(node, &c, '*');
+		c.n = add;
+		if (add != 0)
+			num_arith(node, &c, '+');
+	}
+}
+
+/**
+ * Reverses the order of the top `n` elements, swapping the values of the
+ * nodes from both ends.
+
+ * @param n: The number of elements; the stack holds at least that many.
+
+ * Boxes change hands with their values, nothing is copied.
+ */
+void bulk_rev_nodes(size_t n)
+{
+	stack_t *a = head, *b = head;
+	size_t i;
+	int t;
+
+	for (i = 1; i < n; i++)
+		b = b->next;
+	for (i = 0; i < n / 2; i++, a = a->next, b = b->prev)
+	{
+		t = a->n;
+		a->n = b->n;
+		b->n = t;
+		t = a->tag;
+		a->tag = b->tag;
+		b->tag = t;
+	}
+}
+
+/**
+ * Compares two values for qsort.
+
+ * @param a: The first value, a node.
+
+ * @param b: The second value, a node.
+
+ * @return: See num_cmp.
+ */
+static int sort_cmp(const void *a, const void *b)
+{
+	return (num_cmp((stack_t *)a, (stack_t *)b));
+}
+
+/**
+ * Sorts the top `n` elements, the smallest on top, with boxed values.
+
+ * @param n: The number of elements; the stack holds at least that many.
+
+ * The values (ints and box indexes with their tags) are sorted as nodes
+ * with qsort and written back; boxes change hands, nothing is copied.
+ */
+void bulk_sort_nodes(size_t n)
+{
+	stack_t *vals, *node;
+	size_t i;
+
+	vals = malloc(n * sizeof(*vals));
+	if (vals == NULL)
+		err(4);
+	for (i = 0, node = head; i < n; i++, node = node->next)
+	{
+		vals[i].n = node->n;
+		vals[i].tag = node->tag;
+	}
+	qsort(vals, n, sizeof(*vals), sort_cmp);
+	for (i = 0, node = head; i < n; i++, node = node->next)
+	{
+		node->n = vals[i].n;
+		node->tag = vals[i].tag;
+	}
+	free(vals);
+}
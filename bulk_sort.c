@@ -0,0 +1,77 @@
+#include "monty.h"
+
+/**
+ * Sorts signed values in ascending order (least significant digit radix sort).
+
+ * @param v: The values, handled as signed integers.
+
+ * @param tmp: A scratch array of `n` values.
+
+ * @param n: The number of values.
+
+ * Four passes of one byte each; the sign bit is flipped in the last pass so
+ * that negative values come first. A pass where every value has the same
+ * byte is skipped, so the result is copied back when it ended in `tmp`.
+ */
+static void radix_sort(unsigned int *v, unsigned int *tmp, size_t n)
+{
+	size_t count[256], i, sum, c;
+	unsigned int *src = v, *dst = tmp, *swap, flip;
+	int shift;
+
+	for (shift = 0; shift < 32; shift += 8)
+	{
+		flip = shift == 24 ? 0x80 : 0;
+		memset(count, 0, sizeof(count));
+		for (i = 0; i < n; i++)
+			count[((src[i] >> shift) & 0xff) ^ flip]++;
+		if (count[((src[0] >> shift) & 0xff) ^ flip] == n)
+			continue;
+		for (i = 0, sum = 0; i < 256; i++)
+		{
+			c = count[i];
+			count[i] = sum;
+			sum += c;
+		}
+		for (i = 0; i < n; i++)
+			dst[count[((src[i] >> shift) & 0xff) ^ flip]++] = src[i];
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+	if (src != v)
+		memcpy(v, src, n * sizeof(*v));
+}
+
+/**
+ * Sorts the top `count` elements of the stack, the smallest on top.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * Without an argument the whole stack is sorted. `pall` then prints the
+ * values in ascending order.
+ */
+void sort_nodes(stack_t **stack, unsigned int line_number)
+{
+	unsigned int *v, *tmp;
+	size_t n = pc->n;
+
+	(void)stack;
+	(void)line_number;
+	v = bulk_gather(&n, "sort");
+	if (n < 2)
+		return;
+	if (v == NULL)
+	{
+		bulk_sort_nodes(n);
+		return;
+	}
+	tmp = malloc(n * sizeof(*tmp));
+	if (tmp == NULL)
+		err(4);
+	radix_sort(v, tmp, n);
+	free(tmp);
+	bulk_scatter(v, n);
+}
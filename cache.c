@@ -0,0 +1,209 @@
+#include "monty.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+/**
+ * Hashes the interpreter version, the options and the content of a script
+ * (FNV-1a).
+
+ * @param file: The path of the script.
+
+ * @param hdr: The header holding the options (`flags`), receiving the key
+ * and the size of the script.
+
+ * @return: The script, mapped; NULL when it is empty.
+
+ * The script is mapped rather than read. The mapping is what runs on a
+ * miss and what is compared on a hit, so a script edited meanwhile can
+ * never be stored under the key of the old one.
+ */
+static char *cache_key(char *file, cache_hdr_t *hdr)
+{
+	const unsigned char *src = (const unsigned char *)MONTY_VERSION;
+	unsigned long h = 14695981039346656037UL;
+	struct stat st;
+	size_t i;
+	int fd;
+
+	for (i = 0; i < sizeof(MONTY_VERSION); i++)
+		h = (h ^ src[i]) * 1099511628211UL;
+	h = (h ^ hdr->flags) * 1099511628211UL;
+	fd = open(file, O_RDONLY);
+	if (fd == -1 || fstat(fd, &st) == -1)
+		err(2, file);
+	src = st.st_size == 0 ? NULL
+		: mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (src == MAP_FAILED)
+		err(2, file);
+	for (i = 0; i < (size_t)st.st_size; i++)
+		h = (h ^ src[i]) * 1099511628211UL;
+	hdr->key = h;
+	hdr->src_len = st.st_size;
+	return ((char *)src);
+}
+
+/**
+ * Opens the cache entry of a script if there is a valid one.
+
+ * @param path: The path of the entry.
+
+ * @param key: The header computed for the script.
+
+ * @param src: The script.
+
+ * @return: The entry, open for reading, or -1 on a miss.
+
+ * The key is only a hash: the options stored in the entry and the script
+ * must also be the same, the script byte for byte.
+ */
+static int cache_lookup(char *path, cache_hdr_t *key, char *src)
+{
+	char buf[65536];
+	cache_hdr_t hdr;
+	size_t done = 0;
+	ssize_t n = 1;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return (-1);
+	if (pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+	    memcmp(hdr.magic, CACHE_MAGIC, 8) != 0 || hdr.key != key->key ||
+	    hdr.flags != key->flags || hdr.src_len != key->src_len)
+		n = 0;
+	while (n > 0 && done < hdr.src_len)
+	{
+		n = hdr.src_len - done < sizeof(buf) ? hdr.src_len - done
+			: sizeof(buf);
+		n = pread(fd, buf, n, sizeof(hdr) + hdr.out_len + hdr.err_len +
+			  done);
+		if (n > 0 && memcmp(buf, src + done, n) != 0)
+			n = 0;
+		done += n > 0 ? n : 0;
+	}
+	if (n <= 0)
+	{
+		close(fd);
+		return (-1);
+	}
+	futimens(fd, NULL);
+	return (fd);
+}
+
+/**
+ * Copies bytes of a file to another descriptor without going through user space.
+
+ * @param out: The descriptor to write to.
+
+ * @param fd: The file to copy from.
+
+ * @param off: The offset of the first byte in `fd`.
+
+ * @param len: The number of bytes to copy.
+
+ * When sendfile cannot write to `out` the bytes are mapped and written.
+ */
+void cache_send(int out, int fd, off_t off, size_t len)
+{
+	ssize_t n = 0;
+	char *map;
+
+	while (len > 0 && (n = sendfile(out, fd, &off, len)) > 0)
+		len -= n;
+	if (len == 0 || n == 0)
+		return;
+	map = mmap(NULL, off + len, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		return;
+	while (len > 0 && (n = write(out, map + off, len)) > 0)
+	{
+		off += n;
+		len -= n;
+	}
+	munmap(map, off + len);
+}
+
+/**
+ * Writes the output stored in a cache entry to stdout and stderr, then closes it.
+
+ * @param fd: The entry, open for reading.
+
+ * @return: The exit status stored in the entry.
+
+ * Each stderr record is written once the stdout bytes written before it
+ * are (see cache_err_write), so both streams interleave as they did.
+ */
+int cache_replay(int fd)
+{
+	unsigned long rec[2], done = 0;
+	cache_hdr_t hdr;
+	off_t off, end;
+
+	if (pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))
+	{
+		close(fd);
+		return (EXIT_FAILURE);
+	}
+	off = sizeof(hdr) + hdr.out_len;
+	end = off + hdr.err_len;
+	while (off < end && pread(fd, rec, sizeof(rec), off) == sizeof(rec))
+	{
+		rec[0] = rec[0] < hdr.out_len ? rec[0] : hdr.out_len;
+		if (rec[0] > done)
+			cache_send(STDOUT_FILENO, fd, sizeof(hdr) + done,
+				   rec[0] - done);
+		done = rec[0] > done ? rec[0] : done;
+		cache_send(STDERR_FILENO, fd, off + sizeof(rec), rec[1]);
+		off += sizeof(rec) + rec[1];
+	}
+	cache_send(STDOUT_FILENO, fd, sizeof(hdr) + done, hdr.out_len - done);
+	close(fd);
+	return (hdr.status);
+}
+
+/**
+ * Runs a script through the output cache.
+
+ * @param opts: The options, `cache` holds the cache directory.
+
+ * @return: The exit status of the script.
+
+ * A monty program reads no input, so its output and exit status only depend
+ * on the script, the interpreter version and the options changing what is
+ * printed: `--opt` adds a line on stderr, and `--ir` is keyed too so that
+ * its runs never replay those of the stack interpreter. Whether stdout is
+ * a terminal is part of the key as well: it decides how stdout is buffered,
+ * hence where the errors fall in it. On a hit the stored output is
+ * replayed and the script is never loaded. On a miss the script runs once
+ * into a new entry (see cache_run), which is replayed the same way and kept
+ * if it fits in the size limit, evicting the least recently used entries.
+ */
+int run_cached(options_t *opts)
+{
+	char path[4096], tmp[4096], *src;
+	unsigned long limit;
+	cache_hdr_t hdr;
+	int fd;
+
+	limit = opts->cache_size ? parse_size(opts->cache_size) : 64UL << 20;
+	hdr.flags = (optimize ? CACHE_OPT : 0) | (lower_ir ? CACHE_IR : 0) |
+		(isatty(STDOUT_FILENO) ? CACHE_TTY : 0);
+	src = cache_key(opts->file, &hdr);
+	snprintf(path, sizeof(path), "%s/%016lx", opts->cache, hdr.key);
+	fd = cache_lookup(path, &hdr, src);
+	if (fd == -1)
+	{
+		fd = cache_run(src, opts->cache, &hdr, tmp);
+		if (fd != -1 && sizeof(hdr) + hdr.out_len + hdr.err_len +
+		    hdr.src_len <= limit && rename(tmp, path) == 0)
+			cache_evict(opts->cache, limit);
+		else if (fd != -1)
+			unlink(tmp);
+	}
+	if (src != NULL)
+		munmap(src, hdr.src_len);
+	return (fd == -1 ? EXIT_FAILURE : cache_replay(fd));
+}
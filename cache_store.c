@@ -0,0 +1,174 @@
+#include "signals.h"
+#include "monty.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+/**
+ * Writes to the stderr of a cached run, as one record of the entry.
+
+ * @param cookie: The temporary file receiving the records.
+
+ * @param buf: The bytes written.
+
+ * @param size: The number of bytes.
+
+ * @return: `size`, or -1 if the record could not be written.
+
+ * A record is the amount of stdout already written when stderr was, then
+ * the length of the bytes and the bytes: cache_replay writes both streams
+ * back in the order the run wrote them.
+ */
+static ssize_t cache_err_write(void *cookie, const char *buf, size_t size)
+{
+	unsigned long rec[2];
+	int efd = *(int *)cookie;
+
+	rec[0] = lseek(STDOUT_FILENO, 0, SEEK_CUR) - sizeof(cache_hdr_t);
+	rec[1] = size;
+	if (write(efd, rec, sizeof(rec)) != sizeof(rec) ||
+	    write(efd, buf, size) != (ssize_t)size)
+		return (-1);
+	return (size);
+}
+
+/**
+ * Runs a script in the child process of cache_run.
+
+ * @param src: The script, as it was hashed; NULL when it is empty.
+
+ * @param len: Its size.
+
+ * @param fd: The entry, receiving stdout.
+
+ * @param efd: The temporary file receiving the stderr records.
+
+ * stdout is buffered as it would be without the cache: by line when it is
+ * a terminal (see CACHE_TTY), so the records fall between the same bytes.
+ */
+static void cache_child(char *src, size_t len, int fd, int efd)
+{
+	static cookie_io_functions_t io = {NULL, cache_err_write, NULL, NULL};
+	int tty = isatty(STDOUT_FILENO);
+	FILE *in, *errs;
+
+	dup2(fd, STDOUT_FILENO);
+	if (tty)
+		setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+	in = fmemopen(src != NULL ? src : "", len, "r");
+	errs = fopencookie(&efd, "w", io);
+	if (in == NULL || errs == NULL)
+		err(4);
+	setvbuf(errs, NULL, _IONBF, 0);
+	err_stream = errs;
+	read_file(in);
+	fclose(in);
+	free_nodes();
+	exit(EXIT_SUCCESS);
+}
+
+/**
+ * Runs a script in a child process and records its output in a new cache entry.
+
+ * @param src: The script, as it was hashed; NULL when it is empty.
+
+ * @param dir: The cache directory, the entry is created there.
+
+ * @param hdr: The header of the entry, its key, flags and src_len already
+ * set.
+
+ * @param tmp: Receives the path of the new entry (at least 4096 bytes).
+
+ * @return: The entry, open for reading and writing, or -1 if the script could
+ * not be run (for instance when the child was killed by a signal).
+
+ * The child writes stdout right after the header space of the entry and
+ * its stderr records to an unlinked temporary file, which is appended
+ * once it exits, followed by the script.
+ */
+int cache_run(char *src, char *dir, cache_hdr_t *hdr, char *tmp)
+{
+	char etmp[4096];
+	int fd, efd, status;
+	pid_t pid;
+
+	snprintf(tmp, 4096, "%s/.new-XXXXXX", dir);
+	snprintf(etmp, sizeof(etmp), "%s/.err-XXXXXX", dir);
+	fd = mkstemp(tmp);
+	efd = fd == -1 ? -1 : mkstemp(etmp);
+	if (fd == -1 || efd == -1 || ftruncate(fd, sizeof(*hdr)) == -1 ||
+	    lseek(fd, sizeof(*hdr), SEEK_SET) == -1)
+		err(2, dir);
+	unlink(etmp);
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0)
+		cache_child(src, hdr->src_len, fd, efd);
+	if (pid == -1 || waitpid(pid, &status, 0) == -1 || !WIFEXITED(status))
+	{
+		close(fd);
+		close(efd);
+		unlink(tmp);
+		return (-1);
+	}
+	memcpy(hdr->magic, CACHE_MAGIC, 8);
+	hdr->status = WEXITSTATUS(status);
+	hdr->out_len = lseek(fd, 0, SEEK_END) - sizeof(*hdr);
+	hdr->err_len = lseek(efd, 0, SEEK_END);
+	lseek(efd, 0, SEEK_SET);
+	while (sendfile(fd, efd, NULL, hdr->err_len) > 0)
+		;
+	close(efd);
+	if (hdr->src_len != 0 && write(fd, src, hdr->src_len) !=
+	    (ssize_t)hdr->src_len)
+		memset(hdr->magic, 0, sizeof(hdr->magic));
+	pwrite(fd, hdr, sizeof(*hdr), 0);
+	return (fd);
+}
+
+/**
+ * Removes the least recently used entries until the cache fits in its limit.
+
+ * @param dir: The cache directory.
+
+ * @param limit: The size limit of the cache, in bytes.
+
+ * Entries are the files named with 16 hex digits; their modification time
+ * is their last use.
+ */
+void cache_evict(char *dir, unsigned long limit)
+{
+	char path[4096], oldest[4096];
+	unsigned long total;
+	struct dirent *ent;
+	struct stat st;
+	struct timespec when;
+	DIR *d;
+
+	memset(&when, 0, sizeof(when));
+	do {
+		d = opendir(dir);
+		if (d == NULL)
+			return;
+		total = 0;
+		oldest[0] = '\0';
+		while ((ent = readdir(d)) != NULL)
+		{
+			snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+			if (strlen(ent->d_name) != 16 ||
+			    strspn(ent->d_name, "0123456789abcdef") != 16 ||
+			    stat(path, &st) == -1)
+				continue;
+			total += st.st_size;
+			if (oldest[0] == '\0' || st.st_mtim.tv_sec < when.tv_sec ||
+			    (st.st_mtim.tv_sec == when.tv_sec &&
+			     st.st_mtim.tv_nsec < when.tv_nsec))
+			{
+				when = st.st_mtim;
+				strcpy(oldest, path);
+			}
+		}
+		closedir(d);
+	} while (total > limit && oldest[0] != '\0' && unlink(oldest) == 0);
+}
@@ -0,0 +1,107 @@
+#include "monty.h"
+#include <sys/stat.h>
+
+/**
+ * Rewinds stdout to where it was when a snapshot was taken.
+
+ * @param off: The offset stored in the snapshot, -1 if unknown.
+
+ * What the interrupted run printed after its last checkpoint is printed
+ * again by the resumed run, so it is cut off first. This is only possible
+ * when stdout is a regular file holding at least `off` bytes, that is when
+ * the resumed run writes to the same file (opened with `>>`); otherwise
+ * stdout is left as it is.
+ */
+static void resume_output(long off)
+{
+	struct stat st;
+
+	if (off < 0 || fstat(STDOUT_FILENO, &st) == -1 ||
+	    !S_ISREG(st.st_mode) || st.st_size < off)
+		return;
+	fflush(out_stream);
+	if (ftruncate(STDOUT_FILENO, off) == 0)
+		fseeko(out_stream, off, SEEK_SET);
+}
+
+/**
+ * Writes a checkpoint of a running program.
+
+ * @param prog: The program, stopped between two instructions.
+
+ * @param hdr: The header of the snapshots of the program (its key).
+
+ * @param path: The path of the checkpoint.
+
+ * @param buf: The buffer the snapshot is laid out in, reused between calls.
+
+ * @param cap: The allocated size of `buf`.
+
+ * stdout is flushed first, so the recorded offset covers everything the
+ * program printed before the checkpoint.
+ */
+static void checkpoint(program_t *prog, snap_hdr_t *hdr, char *path,
+		       char **buf, size_t *cap)
+{
+	size_t size;
+
+	fflush(out_stream);
+	hdr->out_off = ftello(out_stream);
+	size = snap_pack(prog, hdr, buf, cap);
+	if (snap_save(path, *buf, size) == -1)
+		err(16, path);
+}
+
+/**
+ * Runs a script with periodic checkpoints, or resumes it from one.
+
+ * @param opts: The options, with `checkpoint_every` and/or `resume` set.
+
+ * @return: 0 once the script ran to its end.
+
+ * With `--resume`, the stack and position are restored from the given
+ * snapshot before running, which must have been taken from the same
+ * program. With `--checkpoint-every n`, the script stops every `n`
+ * instructions to write a snapshot to `--checkpoint` (`file.ckpt` by
+ * default); the checkpoint is removed once the script ends normally and
+ * its output was flushed.
+ */
+int run_checkpointed(options_t *opts)
+{
+	program_t prog;
+	snap_hdr_t hdr;
+	char *buf = NULL, path[4096];
+	size_t every = (size_t)-1, cap = 0;
+	FILE *fd;
+
+	fd = fopen(opts->file, "r");
+	if (fd == NULL)
+		err(2, opts->file);
+	load_program(&prog, fd);
+	fclose(fd);
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.key = prog_key(&prog);
+	if (opts->resume != NULL)
+	{
+		if (snap_load(opts->resume, &prog, &hdr) == -1)
+			err(15, opts->resume, opts->file);
+		resume_output(hdr.out_off);
+	}
+	if (opts->checkpoint_every != NULL)
+		every = parse_size(opts->checkpoint_every);
+	if (every == 0)
+		err(1);
+	if (opts->checkpoint != NULL)
+		snprintf(path, sizeof(path), "%s", opts->checkpoint);
+	else
+		snprintf(path, sizeof(path), "%s.ckpt", opts->file);
+	while (run_steps(&prog, every) == every && prog.pos < prog.len)
+		checkpoint(&prog, &hdr, path, &buf, &cap);
+	fflush(out_stream);
+	if (opts->checkpoint_every != NULL)
+		unlink(path);
+	free(buf);
+	free_program(&prog);
+	free_nodes();
+	return (0);
+}
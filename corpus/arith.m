@@ -0,0 +1,33 @@
+push 12
+push 30
+add
+pint
+push 7
+sub
+pint
+push 3
+mul
+pint
+push 4
+div
+pint
+push 5
+mod
+pint
+push -9
+swap
+pall
+add
+pint
+nop
+push 100
+push 7
+div
+push 3
+mul
+push 2
+sub
+pint
+pop
+pop
+pall
@@ -0,0 +1,45 @@
+#!/bin/sh
+# Checks that a cached run prints what the same run prints uncached:
+# - one script through one cache directory with and without --opt and
+#   --ir, in several orders;
+# - a script that prints and then fails, stdout and stderr in one stream;
+# - --cache with a mode that would ignore it is a usage error.
+# usage: cache_test.sh MONTY
+monty=${1:-./monty}
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+printf 'push 1\npush 2\npop\npush 3\nadd\npint\n' > "$dir/s.m"
+printf 'push 1\npint\npush 2\npall\nadd\nadd\n' > "$dir/f.m"
+fail=0
+for order in "-- --opt --ir" "--ir --opt --" "--opt -- --ir"; do
+	rm -rf "$dir/c"
+	mkdir "$dir/c"
+	for pass in 1 2; do
+		for flag in $order; do
+			[ "$flag" = -- ] && flag=
+			$monty $flag "$dir/s.m" >"$dir/ref" 2>"$dir/ref.err"
+			$monty --cache "$dir/c" $flag "$dir/s.m" >"$dir/out" \
+				2>"$dir/out.err"
+			if ! cmp -s "$dir/ref" "$dir/out" ||
+			   ! cmp -s "$dir/ref.err" "$dir/out.err"; then
+				echo "FAIL: pass $pass of '$order', '$flag'"
+				fail=1
+			fi
+		done
+	done
+done
+$monty "$dir/f.m" >"$dir/ref" 2>&1
+status=$?
+for pass in 1 2; do
+	$monty --cache "$dir/c" "$dir/f.m" >"$dir/out" 2>&1
+	if [ $? != $status ] || ! cmp -s "$dir/ref" "$dir/out"; then
+		echo "FAIL: pass $pass of a failing script"
+		fail=1
+	fi
+done
+if $monty --cache "$dir/c" --lanes "$dir/s.m" "$dir/s.m" 2>/dev/null; then
+	echo "FAIL: --cache with --lanes"
+	fail=1
+fi
+[ $fail = 0 ] && echo "cache_test: ok"
+exit $fail
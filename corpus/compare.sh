@@ -0,0 +1,28 @@
+#!/bin/sh
+# Prints the size of each build and its run time over the benchmark scripts,
+# the Brainfuck ones (*.bf) run with --bf.
+# usage: compare.sh BENCH_DIR RUNS BINARY...
+bench=$1
+runs=$2
+shift 2
+
+printf '%-24s %10s %10s %12s\n' build text total "time (ms)"
+for bin in "$@"; do
+	[ -x "$bin" ] || continue
+	text=$(size "$bin" | awk 'NR == 2 { print $1 }')
+	total=$(size "$bin" | awk 'NR == 2 { print $4 }')
+	start=$(date +%s%N)
+	i=0
+	while [ "$i" -lt "$runs" ]; do
+		for m in "$bench"/*.m; do
+			"$bin" "$m" >/dev/null 2>&1
+		done
+		for b in "$bench"/*.bf; do
+			echo 23 | "$bin" --bf "$b" >/dev/null 2>&1
+		done
+		i=$((i + 1))
+	done
+	end=$(date +%s%N)
+	printf '%-24s %10s %10s %12s\n' "$bin" "$text" "$total" \
+		$(((end - start) / 1000000))
+done
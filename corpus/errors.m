@@ -0,0 +1,5 @@
+push 1
+push 0
+pint
+pall
+div
@@ -0,0 +1,68 @@
+#!/bin/sh
+# Writes the larger benchmark scripts used to train and compare builds.
+# usage: gen_bench.sh DIR
+out=${1:-build/bench}
+mkdir -p "$out"
+
+# arithmetic chains: the find_func/handler dispatch path
+awk 'BEGIN {
+	for (i = 0; i < 40000; i++) {
+		print "push " i % 97 + 1; print "push " i % 13 + 1
+		print "mul"; print "push " i % 7 + 1; print "add"
+		print "push 3"; print "swap"; print "sub"
+		print "push " i % 5 + 1; print "mod"; print "pint"; print "pop"
+	}
+}' > "$out/arith.m"
+
+# deep stack built then dumped and reduced
+awk 'BEGIN {
+	for (i = 0; i < 200000; i++) print "push " i
+	print "pall"
+	for (i = 1; i < 200000; i++) print "add"
+	print "pint"
+}' > "$out/deep.m"
+
+# strings, rotations and comments
+awk 'BEGIN {
+	for (i = 0; i < 2000; i++) {
+		print "# block " i
+		print "push 0"
+		for (c = 65; c < 91; c++) print "push " c
+		print "pstr"; print "rotl"; print "rotr"; print "pchar"
+		for (c = 0; c < 27; c++) print "pop"
+	}
+}' > "$out/strings.m"
+
+# alternating queue and stack regions
+awk 'BEGIN {
+	for (i = 0; i < 3000; i++) {
+		print "queue"; print "push " i; print "push " i + 1
+		print "stack"; print "push " i + 2; print "add"; print "add"
+	}
+	print "pall"
+}' > "$out/queue.m"
+
+# Brainfuck, run with --bf: the sample programs, then scan loops sweeping a
+# long row of non-zero cells back and forth
+cp "$(dirname "$0")"/../bf/*.bf "$out"
+awk 'BEGIN {
+	printf ">>>"
+	for (i = 0; i < 20000; i++) printf "+>"
+	for (i = 0; i < 20003; i++) printf "<"
+	printf "\n"
+	for (i = 0; i < 250; i++) printf "+"
+	printf "[>"
+	for (i = 0; i < 250; i++) printf "+"
+	print "[>>[>]<[<]<-]<-]"
+}' > "$out/scan.bf"
+
+# nested counting loops: runs of + and - and moves, clear loops
+awk 'BEGIN {
+	for (i = 0; i < 200; i++) printf "+"
+	printf "[>"
+	for (i = 0; i < 255; i++) printf "+"
+	printf "[>"
+	for (i = 0; i < 100; i++) printf "+"
+	print "[>+>++>+++<<<-]>>>>[-]<<<<<-]<-]"
+	print ">>>.>.>.>."
+}' > "$out/loops.bf"
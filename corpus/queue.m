@@ -0,0 +1,18 @@
+queue
+push 1
+push 2
+push 3
+pall
+stack
+push 4
+push 5
+pall
+queue
+push 6
+add
+pall
+stack
+swap
+pop
+pint
+pall
@@ -0,0 +1,23 @@
+# prints "Holberton" then the same word rotated
+push 0
+push 110
+push 111
+push 116
+push 114
+push 101
+push 98
+push 108
+push 111
+push 72
+pstr
+pchar
+rotl
+pstr
+rotr
+rotr
+pstr
+pchar
+push 200
+pstr
+pop
+pchar
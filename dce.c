@@ -0,0 +1,116 @@
+#include "monty.h"
+
+/**
+ * Runs one instruction of a program on the stack of values of the analysis.
+
+ * @param d: The analysis.
+
+ * @param c: The instruction.
+
+ * @param t: When the instruction runs (its index + 1).
+
+ * @return: 0 to go on, 1 to stop the analysis at this instruction.
+
+ * `push` starts a new web. `pop`, arithmetic and `swap` join the webs of
+ * the values they use, so a web is only removed with every instruction
+ * touching its values, and the remaining instructions still find their
+ * operands at the same place. `pint`, `pchar`, `div` and `mod` depend on
+ * the values they use, which makes their webs live. `pall`, `pstr` and the
+ * rotations depend on the whole stack: every value on it at that time is
+ * made live. The analysis stops at an instruction that must fail (its
+ * stack is too short, or it was loaded as an error), or that it does not
+ * know, in which case every value left is live.
+ */
+static int dce_step(dce_t *d, code_t *c, size_t t)
+{
+	op_func f = c->f;
+	dce_value_t a, b;
+	size_t need = 0, w;
+
+	d->web[t - 1] = f == nop ? DCE_DROP : DCE_KEEP;
+	if (f == push_stack || f == push_queue || f == push_big_stack ||
+	    f == push_big_queue)
+	{
+		w = d->web[t - 1] = d->nwebs++;
+		d->parent[w] = w;
+		d->live[w] = 0;
+		val_push(d, w, t, f == push_queue || f == push_big_queue);
+		return (0);
+	}
+	if (f == nop || f == print_stack || f == print_str || f == rotl ||
+	    f == rotr)
+	{
+		d->last_all = f == nop ? d->last_all : t;
+		return (0);
+	}
+	if (f == pop_top || f == print_top || f == print_char)
+		need = 1;
+	else if (f == add_nodes || f == sub_nodes || f == mul_nodes ||
+		 f == div_nodes || f == mod_nodes || f == swap_nodes)
+		need = 2;
+	else
+		d->last_all = t;
+	if (d->last_all == t || d->depth < need)
+		return (1);
+	if (f == print_top || f == print_char)
+	{
+		d->live[web_find(d, d->vals[d->front].web)] = 1;
+		return (0);
+	}
+	a = val_pop(d);
+	d->web[t - 1] = a.web;
+	if (f == pop_top)
+		return (0);
+	b = val_pop(d);
+	w = d->web[t - 1] = web_union(d, a.web, b.web);
+	d->live[w] |= f == div_nodes || f == mod_nodes;
+	val_push(d, w, f == swap_nodes ? a.birth : t, 0);
+	if (f == swap_nodes)
+		val_push(d, w, b.birth, 0);
+	return (0);
+}
+
+/**
+ * Removes the instructions of a program that cannot affect its output.
+
+ * @param prog: The loaded program, which will run on an empty stack.
+
+ * An instruction is removed when it only produces, combines or drops values
+ * that are never printed and cannot make an instruction fail (see
+ * dce_step), or when it is a `nop`. Every other instruction, and every
+ * instruction from the one where the analysis stopped, is kept with its
+ * line number, so errors are reported as before. The number of removed
+ * instructions is printed on stderr.
+ */
+void dce_program(program_t *prog)
+{
+	dce_t d;
+	char *keep;
+	size_t i, stop, removed;
+
+	memset(&d, 0, sizeof(d));
+	d.parent = malloc((prog->len + 1) * sizeof(size_t));
+	d.web = malloc((prog->len + 1) * sizeof(size_t));
+	d.live = malloc(prog->len + 1);
+	keep = malloc(prog->len + 1);
+	if (d.parent == NULL || d.web == NULL || d.live == NULL || keep == NULL)
+		err(4);
+	for (stop = 0; stop < prog->len; stop++)
+	{
+		if (dce_step(&d, &prog->code[stop], stop + 1))
+			break;
+	}
+	while (d.depth > 0)
+		val_pop(&d);
+	for (i = 0; i < prog->len; i++)
+		keep[i] = i >= stop || d.web[i] == DCE_KEEP ||
+			(d.web[i] != DCE_DROP && d.live[web_find(&d, d.web[i])]);
+	removed = compact_program(prog, keep);
+	fprintf(err_stream, "opt: removed %lu of %lu instructions\n",
+		(unsigned long)removed, (unsigned long)(prog->len + removed));
+	free(d.parent);
+	free(d.web);
+	free(d.live);
+	free(d.vals);
+	free(keep);
+}
@@ -0,0 +1,99 @@
+#include "monty.h"
+
+/**
+ * Finds the web a web was merged into.
+
+ * @param d: The analysis.
+
+ * @param w: The web.
+
+ * @return: The root of the web, halving the path on the way.
+ */
+size_t web_find(dce_t *d, size_t w)
+{
+	while (d->parent[w] != w)
+	{
+		d->parent[w] = d->parent[d->parent[w]];
+		w = d->parent[w];
+	}
+	return (w);
+}
+
+/**
+ * Merges two webs.
+
+ * @param d: The analysis.
+
+ * @param a: The first web.
+
+ * @param b: The second web.
+
+ * @return: The root of the merged web, live if either web was.
+ */
+size_t web_union(dce_t *d, size_t a, size_t b)
+{
+	a = web_find(d, a);
+	b = web_find(d, b);
+	if (a != b)
+	{
+		d->parent[b] = a;
+		d->live[a] |= d->live[b];
+	}
+	return (a);
+}
+
+/**
+ * Adds a value to the stack of the analysis.
+
+ * @param d: The analysis.
+
+ * @param web: The web of the value.
+
+ * @param birth: When the value is created.
+
+ * @param bottom: 1 to add the value at the bottom (queue), 0 on top.
+ */
+void val_push(dce_t *d, size_t web, size_t birth, int bottom)
+{
+	dce_value_t *vals;
+	size_t i;
+
+	if (d->depth == d->cap)
+	{
+		vals = malloc((d->cap * 2 + 64) * sizeof(*vals));
+		if (vals == NULL)
+			err(4);
+		for (i = 0; i < d->depth; i++)
+			vals[i] = d->vals[(d->front + i) % d->cap];
+		free(d->vals);
+		d->vals = vals;
+		d->cap = d->cap * 2 + 64;
+		d->front = 0;
+	}
+	if (bottom)
+		i = (d->front + d->depth) % d->cap;
+	else
+		i = d->front = (d->front + d->cap - 1) % d->cap;
+	d->vals[i].web = web;
+	d->vals[i].birth = birth;
+	d->depth++;
+}
+
+/**
+ * Removes the top value from the stack of the analysis.
+
+ * @param d: The analysis; the stack is not empty.
+
+ * @return: The value. Its web is made live if the whole stack was looked
+ * at while the value was on it.
+ */
+dce_value_t val_pop(dce_t *d)
+{
+	dce_value_t v = d->vals[d->front];
+
+	d->front = (d->front + 1) % d->cap;
+	d->depth--;
+	if (d->last_all > v.birth)
+		d->live[web_find(d, v.web)] = 1;
+	return (v);
+}
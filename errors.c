@@ -1,52 +1,90 @@
 #include "monty.h"
 
 /**
- * Prints appropriate error messages based on the provided error code.
+ * Prints the error message matching the provided error code to a stream.
 
- * Error codes and their meanings:
+ * @param fp: The stream the message is written to.
 
- * 1:  The program received either no files or more than one file as input.
- * 2:  The provided file cannot be opened or read.
- * 3:  The file contains an invalid instruction. Please refer to the program documentation for valid instructions.
- * 4:  The program encountered an out-of-memory error while allocating memory.
- * 5:  The parameter passed to the `push` instruction is not an integer.
- * 6:  The stack is empty when trying to perform a `pint` operation.
- * 7:  The stack is empty when trying to perform a `pop` operation.
- * 8:  The stack is too short to perform the desired operation.
+ * @param error_code: The error code, see err, more_err and string_err.
+
+ * @param ag: The arguments of the message (file name, line number, opcode).
 
+ * The messages are kept in one place so that modes running several programs
+ * at once (see lanes.c) can report an error without exiting.
  */
-void err(int error_code, ...)
+void vprint_err(FILE *fp, int error_code, va_list ag)
 {
-	va_list ag;
-	char *op;
 	int l_num;
 
-	va_start(ag, error_code);
 	switch (error_code)
 	{
 		case 1:
-			fprintf(stderr, "USAGE: monty file\n");
+			fprintf(fp, "USAGE: monty file\n");
 			break;
 		case 2:
-			fprintf(stderr, "Error: Can't open file %s\n",
-				va_arg(ag, char *));
+			fprintf(fp, "Error: Can't open file %s\n", va_arg(ag, char *));
 			break;
 		case 3:
 			l_num = va_arg(ag, int);
-			op = va_arg(ag, char *);
-			fprintf(stderr, "L%d: unknown instruction %s\n", l_num, op);
+			fprintf(fp, "L%d: unknown instruction %s\n", l_num,
+				va_arg(ag, char *));
 			break;
 		case 4:
-			fprintf(stderr, "Error: malloc failed\n");
+			fprintf(fp, "Error: malloc failed\n");
 			break;
 		case 5:
-			fprintf(stderr, "L%d: usage: push integer\n", va_arg(ag, int));
+			fprintf(fp, "L%d: usage: push integer\n", va_arg(ag, int));
+			break;
+		case 6:
+			fprintf(fp, "L%d: can't pint, stack empty\n", va_arg(ag, int));
+			break;
+		case 7:
+			fprintf(fp, "L%d: can't pop an empty stack\n", va_arg(ag, int));
+			break;
+		case 8:
+			l_num = va_arg(ag, unsigned int);
+			fprintf(fp, "L%d: can't %s, stack too short\n", l_num,
+				va_arg(ag, char *));
+			break;
+		case 9:
+			fprintf(fp, "L%d: division by zero\n", va_arg(ag, unsigned int));
+			break;
+		case 10:
+			fprintf(fp, "L%d: can't pchar, value out of range\n",
+				va_arg(ag, int));
+			break;
+		case 11:
+			fprintf(fp, "L%d: can't pchar, stack empty\n", va_arg(ag, int));
 			break;
 		default:
+			more_msg(fp, error_code, ag);
 			break;
 	}
-	free_nodes();
-	exit(EXIT_FAILURE);
+}
+
+/**
+ * Prints appropriate error messages based on the provided error code.
+
+ * Error codes and their meanings:
+
+ * 1:  The program received either no files or more than one file as input.
+ * 2:  The provided file cannot be opened or read.
+ * 3:  The file contains an invalid instruction. Please refer to the program documentation for valid instructions.
+ * 4:  The program encountered an out-of-memory error while allocating memory.
+ * 5:  The parameter passed to the `push` instruction is not an integer.
+ * 6:  The stack is empty when trying to perform a `pint` operation.
+ * 7:  The stack is empty when trying to perform a `pop` operation.
+ * 8:  The stack is too short to perform the desired operation.
+
+ */
+void err(int error_code, ...)
+{
+	va_list ag;
+
+	va_start(ag, error_code);
+	vprint_err(err_stream, error_code, ag);
+	va_end(ag);
+	die();
 }
 
 /**
@@ -61,34 +99,11 @@ void err(int error_code, ...)
 void more_err(int error_code, ...)
 {
 	va_list ag;
-	char *op;
-	int l_num;
 
 	va_start(ag, error_code);
-	switch (error_code)
-	{
-		case 6:
-			fprintf(stderr, "L%d: can't pint, stack empty\n",
-				va_arg(ag, int));
-			break;
-		case 7:
-			fprintf(stderr, "L%d: can't pop an empty stack\n",
-				va_arg(ag, int));
-			break;
-		case 8:
-			l_num = va_arg(ag, unsigned int);
-			op = va_arg(ag, char *);
-			fprintf(stderr, "L%d: can't %s, stack too short\n", l_num, op);
-			break;
-		case 9:
-			fprintf(stderr, "L%d: division by zero\n",
-				va_arg(ag, unsigned int));
-			break;
-		default:
-			break;
-	}
-	free_nodes();
-	exit(EXIT_FAILURE);
+	vprint_err(err_stream, error_code, ag);
+	va_end(ag);
+	die();
 }
 
 /**
@@ -103,21 +118,64 @@ void more_err(int error_code, ...)
 void string_err(int error_code, ...)
 {
 	va_list ag;
-	int l_num;
 
 	va_start(ag, error_code);
-	l_num = va_arg(ag, int);
+	vprint_err(err_stream, error_code, ag);
+	va_end(ag);
+	die();
+}
+
+/**
+ * Prints the messages of the error codes used by the interpreter modes.
+
+ * @param fp: The stream the message is written to.
+
+ * @param error_code: The error code.
+
+ * @param ag: The arguments of the message.
+
+ * Error codes and their meanings:
+
+ * 12:  A line of a lanes file does not hold as many values as the first one.
+ * 13:  An instruction cannot run in lanes mode.
+ * 14:  A program ran out of its instruction budget before this line.
+ * 15:  A snapshot cannot be read or was taken from another program.
+ * 16:  A checkpoint cannot be written.
+ * 17-20:  See op_msg.
+ */
+void more_msg(FILE *fp, int error_code, va_list ag)
+{
+	char *name;
+	int l_num;
+
 	switch (error_code)
 	{
-		case 10:
-			fprintf(stderr, "L%d: can't pchar, value out of range\n", l_num);
+		case 12:
+			name = va_arg(ag, char *);
+			l_num = va_arg(ag, int);
+			fprintf(fp, "Error: %s:%d: expected %d values\n", name, l_num,
+				va_arg(ag, int));
 			break;
-		case 11:
-			fprintf(stderr, "L%d: can't pchar, stack empty\n", l_num);
+		case 13:
+			l_num = va_arg(ag, int);
+			fprintf(fp, "L%d: can't %s in lanes mode\n", l_num,
+				va_arg(ag, char *));
+			break;
+		case 14:
+			fprintf(fp, "L%d: instruction budget exceeded\n",
+				va_arg(ag, int));
+			break;
+		case 15:
+			name = va_arg(ag, char *);
+			fprintf(fp, "Error: %s is not a checkpoint of %s\n", name,
+				va_arg(ag, char *));
+			break;
+		case 16:
+			fprintf(fp, "Error: Can't write checkpoint %s\n",
+				va_arg(ag, char *));
 			break;
 		default:
+			op_msg(fp, error_code, ag);
 			break;
 	}
-	free_nodes();
-	exit(EXIT_FAILURE);
 }
@@ -0,0 +1,126 @@
+#include "monty.h"
+
+/**
+ * Prints the messages of the error codes used by the added opcodes.
+
+ * @param fp: The stream the message is written to.
+
+ * @param error_code: The error code.
+
+ * @param ag: The arguments of the message.
+
+ * Error codes and their meanings:
+
+ * 17:  The arguments of a bulk opcode are not valid.
+ * 18:  The stack is empty when trying to perform a `store` operation.
+ * 19:  A register number is out of range.
+ * 20:  A value does not fit in the int of a lane.
+ * 21-22:  See bf_msg.
+ * 23-24:  See spill_msg.
+ */
+void op_msg(FILE *fp, int error_code, va_list ag)
+{
+	int l_num;
+
+	if (error_code > 22)
+	{
+		spill_msg(fp, error_code, ag);
+		return;
+	}
+	if (error_code > 20)
+	{
+		bf_msg(fp, error_code, ag);
+		return;
+	}
+	l_num = va_arg(ag, int);
+	switch (error_code)
+	{
+		case 17:
+			fprintf(fp, "L%d: usage: %s\n", l_num, va_arg(ag, char *));
+			break;
+		case 18:
+			fprintf(fp, "L%d: can't %s, stack empty\n", l_num,
+				va_arg(ag, char *));
+			break;
+		case 19:
+			fprintf(fp, "L%d: register %d out of range\n", l_num,
+				va_arg(ag, int));
+			break;
+		case 20:
+			fprintf(fp, "L%d: %s overflows in lanes mode\n", l_num,
+				va_arg(ag, char *));
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Prints the messages of the error codes of the Brainfuck mode.
+
+ * @param fp: The stream the message is written to.
+
+ * @param error_code: The error code.
+
+ * @param ag: The arguments of the message.
+
+ * Error codes and their meanings:
+
+ * 21:  A bracket of a Brainfuck program has no match.
+ * 22:  The data pointer left the tape.
+ */
+void bf_msg(FILE *fp, int error_code, va_list ag)
+{
+	char *name;
+	int l_num;
+
+	name = va_arg(ag, char *);
+	switch (error_code)
+	{
+		case 21:
+			l_num = va_arg(ag, int);
+			fprintf(fp, "Error: %s:%d: unmatched %c\n", name, l_num,
+				va_arg(ag, int));
+			break;
+		case 22:
+			fprintf(fp, "Error: %s: data pointer moved %s the tape\n",
+				name, va_arg(ag, char *));
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Prints the messages of the error codes of the spill mode.
+
+ * @param fp: The stream the message is written to.
+
+ * @param error_code: The error code.
+
+ * @param ag: The arguments of the message.
+
+ * Error codes and their meanings:
+
+ * 23:  The memory budget is too small for the spill mode.
+ * 24:  Two options that cannot be used together (see check_modes).
+ */
+void spill_msg(FILE *fp, int error_code, va_list ag)
+{
+	char *name;
+
+	name = va_arg(ag, char *);
+	switch (error_code)
+	{
+		case 23:
+			fprintf(fp, "Error: --mem-budget %s is below %luM\n", name,
+				va_arg(ag, unsigned long));
+			break;
+		case 24:
+			fprintf(fp, "Error: %s cannot be used with %s\n", name,
+				va_arg(ag, char *));
+			break;
+		default:
+			break;
+	}
+}
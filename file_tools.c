@@ -23,105 +23,117 @@ void open_file(char *file_name)
 
 
 /**
- * Reads data from an open file descriptor into a provided user-defined buffer.
+ * Loads the program held in an open file and executes it.
 
- * @param fd: The file descriptor for the previously opened file.
+ * @param fd: The file stream for the previously opened file.
 
- * @param buffer: A pointer to the user-defined buffer where the read data will be stored.
-
- * @param buffer_size: The size of the user-defined buffer in bytes.
-
- * @return: The number of bytes read, or -1 if an error occurs.
+ * The whole file is loaded into a program first, split into stack and queue
+ * regions, and only then executed region by region, or with `--ir` on the
+ * register backend.
  */
 
 void read_file(FILE *fd)
 {
-	int line_number, format = 0;
-	char *buffer = NULL;
-	size_t len = 0;
+	program_t prog;
 
-	for (line_number = 1; getline(&buffer, &len, fd) != -1; line_number++)
-	{
-		format = parse_line(buffer, line_number, format);
-	}
-	free(buffer);
+	load_program(&prog, fd);
+	if (lower_ir)
+		run_ir(&prog);
+	else
+		run_program(&prog);
+	free_program(&prog);
 }
 
 
 /**
- * parses a line from the file into tokens and determines which function to call based on the extracted data.
+ * parses a line from the file into tokens and appends the matching instruction to the program.
+
+ * @param prog: The program being loaded.
 
  * @param buffer: The line of text to be parsed, typically containing separated tokens.
 
  * @param line_number: The line number of the current line being parsed.
 
- * @param format: An integer flag indicating the expected data structure format:
-
- *     - 0: Nodes will be entered as a stack (LIFO).
- *     - 1: Nodes will be entered as a queue (FIFO).
+ * `stack` and `queue` directives are not instructions: they switch the format
+ * of the program's current region instead (see set_format). Every other
+ * opcode is resolved with find_func for the format of the current region.
 
- * @return:
-
- *     - 0 if the parsed data indicates a stack operation.
- *     - 1 if the parsed data indicates a queue operation.
- *     - Additional logic (e.g., error handling) can be implemented based on the parsed data.
-
- * Note: The specific format of tokens and data values within the line should be clarified in additional documentation.
+ * Note: Empty lines and comments do not produce any instruction.
  */
 
-int parse_line(char *buffer, int line_number, int format)
+void parse_line(program_t *prog, char *buffer, int line_number)
 {
-	char *opcode, *value;
+	char *opcode, *value, *value2;
 	const char *delim = "\n ";
+	op_func f;
+	code_t *code;
+	int n = 0, bad;
 
 	if (buffer == NULL)
 		err(4);
 
 	opcode = strtok(buffer, delim);
 	if (opcode == NULL)
-		return (format);
+		return;
 	value = strtok(NULL, delim);
+	value2 = strtok(NULL, delim);
 
-	if (strcmp(opcode, "stack") == 0)
-		return (0);
-	if (strcmp(opcode, "queue") == 0)
-		return (1);
+	if (strcmp(opcode, "stack") == 0 || strcmp(opcode, "queue") == 0)
+	{
+		set_format(prog, opcode[0] == 'q');
+		return;
+	}
+	if (opcode[0] == '#')
+		return;
 
-	find_func(opcode, value, line_number, format);
-	return (format);
+	f = find_func(opcode, prog->regions[prog->nregions - 1].format, &opcode);
+	if (f == NULL)
+	{
+		opcode = strdup(opcode);
+		if (opcode == NULL)
+			err(4);
+		f = bad_op;
+	}
+	else if (f == push_stack || f == push_queue)
+	{
+		bad = parse_push(value, &n);
+		if (bad == 2)
+		{
+			opcode = strdup(value);
+			if (opcode == NULL)
+				err(4);
+			f = f == push_stack ? push_big_stack : push_big_queue;
+		}
+		else if (bad)
+			f = bad_push;
+	}
+	code = add_code(prog, f, n, line_number, opcode);
+	if (bulk_args(f, value, value2, code))
+		code->f = bad_bulk;
 }
 
 /**
- * Determines the appropriate function to call based on the provided opcode and arguments.
+ * Determines the function handling the provided opcode.
 
  * @param opcode: The keyword or symbol identifying the desired operation.
 
- * @param value: The optional argument accompanying the opcode, if applicable.
-
  * @param format: An integer flag indicating the data structure format:
 
  *     - 0: Nodes are stored as a stack (Last In First Out).
  *     - 1: Nodes are stored as a queue (First In First Out).
 
- * @param ln: The line number where the opcode was found (for error reporting).
-
- * @return: void
+ * @param name: Where to store the static text of the opcode when it is found.
 
- * This function identifies the corresponding function to be called based on the provided
- * `opcode`, potentially considering the `value` and `format` for specialized operations.
- * It typically does not directly execute the function but sets up the necessary context
- * or prepares arguments for proper function invocation.
+ * @return: The handler for `opcode`, or NULL if the opcode is unknown.
 
- * Note: The specific meanings and expected formats of `opcode` and `value` should be
- * clearly documented in separate references or within the function implementation itself.
+ * `push`, `range` and `load` are the only opcodes depending on `format`;
+ * they are resolved here once, when the program is loaded, to their stack
+ * or queue handler.
  */
-void find_func(char *opcode, char *value, int ln, int format)
+op_func find_func(char *opcode, int format, char **name)
 {
-	int i;
-	int flag;
-
-	instruction_t func_list[] = {
-		{"push", add_to_stack},
+	static instruction_t func_list[] = {
+		{"push", push_stack},
 		{"pall", print_stack},
 		{"pint", print_top},
 		{"pop", pop_top},
@@ -136,82 +148,76 @@ void find_func(char *opcode, char *value, int ln, int format)
 		{"pstr", print_str},
 		{"rotl", rotl},
 		{"rotr", rotr},
+		{"sum", sum_nodes},
+		{"prod", prod_nodes},
+		{"rev", rev_nodes},
+		{"sort", sort_nodes},
+		{"addc", addc_nodes},
+		{"mulc", mulc_nodes},
+		{"range", range_stack},
+		{"store", store_reg},
+		{"load", load_stack},
+		{"pick", pick_nodes},
+		{"roll", roll_nodes},
 		{NULL, NULL}
 	};
+	int i;
 
-	if (opcode[0] == '#')
-		return;
-
-	for (flag = 1, i = 0; func_list[i].opcode != NULL; i++)
+	for (i = 0; func_list[i].opcode != NULL; i++)
 	{
 		if (strcmp(opcode, func_list[i].opcode) == 0)
 		{
-			call_fun(func_list[i].f, opcode, value, ln, format);
-			flag = 0;
+			*name = func_list[i].opcode;
+			if (func_list[i].f == push_stack && format == 1)
+				return (push_queue);
+			if (func_list[i].f == range_stack && format == 1)
+				return (range_queue);
+			if (func_list[i].f == load_stack && format == 1)
+				return (load_queue);
+			return (func_list[i].f);
 		}
 	}
-	if (flag == 1)
-		err(3, ln, opcode);
+	return (NULL);
 }
 
 
 /**
- * Executes the given function with appropriate arguments parsed from the opcode and value.
-
- * @param func: A pointer to the function to be called.
-
- * @param op: The string representing the parsed opcode, identifying the desired operation.
-
- * @param val: The string representing the parsed numeric value associated with the opcode (optional).
-
- * @param ln: The line number where the opcode was found (used for error reporting).
-
- * @param format: An integer flag indicating the data structure format:
+ * Parses the argument of a `push` instruction.
 
- *     - 0: Nodes are stored as a stack (Last In First Out).
- *     - 1: Nodes are stored as a queue (First In First Out).
-
- * @return: void
+ * @param val: The string representing the parsed numeric value (may be NULL).
 
- * This function takes the previously parsed information from the opcode and value, including
- * the format, and performs the following actions:
+ * @param n: Where to store the parsed value.
 
- * 1. Converts the `val` string to the appropriate numeric data type (if applicable).
- * 2. Sets up any necessary context or prepares arguments based on the `format` and operation.
- * 3. Executes the specified function pointed to by `func` with the prepared arguments.
- * 4. Handles any potential errors or exceptions that may occur during the function call.
-
- * Note: The specific meanings and expected formats of `op` and `val` should be clearly
- * documented in separate references or within the function implementation itself.
+ * @return: 0 on success, 1 if `val` is not an integer, 2 if it is one that
+ * does not fit in an int.
 
+ * The checks are the ones `push` has always done: an optional leading '-'
+ * followed by digits only. Larger integers used to wrap through atoi; the
+ * loader now pushes them as they are (see push_big_stack).
  */
-void call_fun(op_func func, char *op, char *val, int ln, int format)
+int parse_push(char *val, int *n)
 {
-	stack_t *node;
+	unsigned long mag = 0;
 	int flag;
 	int i;
 
 	flag = 1;
-	if (strcmp(op, "push") == 0)
+	if (val != NULL && val[0] == '-')
 	{
-		if (val != NULL && val[0] == '-')
-		{
-			val = val + 1;
-			flag = -1;
-		}
-		if (val == NULL)
-			err(5, ln);
-		for (i = 0; val[i] != '\0'; i++)
-		{
-			if (isdigit(val[i]) == 0)
-				err(5, ln);
-		}
-		node = create_node(atoi(val) * flag);
-		if (format == 0)
-			func(&node, ln);
-		if (format == 1)
-			add_to_queue(&node, ln);
+		val = val + 1;
+		flag = -1;
 	}
-	else
-		func(&head, ln);
+	if (val == NULL)
+		return (1);
+	for (i = 0; val[i] != '\0'; i++)
+	{
+		if (isdigit(val[i]) == 0)
+			return (1);
+		if (mag <= 2147483648UL)
+			mag = mag * 10 + (val[i] - '0');
+	}
+	if (mag > 2147483647UL + (flag == -1))
+		return (2);
+	*n = flag == -1 ? (int)(0U - (unsigned int)mag) : (int)mag;
+	return (0);
 }
@@ -0,0 +1,205 @@
+#include "monty.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+
+/**
+ * Hashes every prefix of a program that ends at a snapshot position.
+
+ * @param prog: The loaded program.
+
+ * @param every: The number of instructions between two snapshots.
+
+ * @param count: Receives the number of snapshot positions.
+
+ * @return: The hashes; entry k covers the first min((k + 1) * every, len)
+ * instructions, so the last one covers the whole program.
+
+ * The hash rolls along the program once, continuing the one of prog_key.
+ * It starts with `every` too: a snapshot stores the output since the
+ * previous one, so snapshots taken at another interval cannot be replayed.
+ */
+static unsigned long *prefix_hashes(program_t *prog, size_t every,
+				    size_t *count)
+{
+	const unsigned char *v = (const unsigned char *)MONTY_VERSION;
+	unsigned long h = 14695981039346656037UL, *hs;
+	size_t i, r, pos = 0;
+
+	*count = prog->len / every + (prog->len % every != 0);
+	hs = malloc((*count + 1) * sizeof(*hs));
+	if (hs == NULL)
+		err(4);
+	for (i = 0; i < sizeof(MONTY_VERSION); i++)
+		h = (h ^ v[i]) * 1099511628211UL;
+	h = (h ^ every) * 1099511628211UL;
+	for (r = 0; r < prog->nregions; r++)
+	{
+		for (i = 0; i < prog->regions[r].len; i++)
+		{
+			h = code_hash(h, &prog->code[prog->regions[r].start + i],
+				      prog->regions[r].format);
+			if (++pos % every == 0 || pos == prog->len)
+				hs[(pos - 1) / every] = h;
+		}
+	}
+	return (hs);
+}
+
+/**
+ * Restores the longest prefix of a program with a snapshot at each position.
+
+ * @param in: The incremental run, for its directory and snapshot interval.
+
+ * @param prog: The loaded program, moved to the end of the prefix.
+
+ * @param hs: The prefix hashes, see prefix_hashes.
+
+ * @param count: The number of prefix hashes.
+
+ * @return: The number of snapshots found, in a row from the first one.
+
+ * Each snapshot holds the output printed since the previous one, which is
+ * copied to stdout as long as the snapshots follow each other; the stack
+ * is then restored from the last one. Replayed snapshots are touched, so
+ * cache_evict keeps the ones still in use.
+ */
+static size_t prefix_restore(incr_t *in, program_t *prog, unsigned long *hs,
+			     size_t count)
+{
+	char path[4096];
+	snap_hdr_t hdr;
+	struct stat st;
+	size_t k, off;
+	int fd = -1;
+
+	fflush(stdout);
+	for (k = 0; k < count; k++)
+	{
+		snprintf(path, sizeof(path), "%s/%016lx", in->dir, hs[k]);
+		fd = open(path, O_RDONLY);
+		if (fd == -1 || fstat(fd, &st) == -1 ||
+		    pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+		    memcmp(hdr.magic, SNAP_MAGIC, 8) != 0 || hdr.key != hs[k] ||
+		    (hdr.pos - 1) / in->every != k ||
+		    (size_t)st.st_size < sizeof(hdr) + hdr.words * sizeof(int))
+			break;
+		off = sizeof(hdr) + hdr.words * sizeof(int);
+		futimens(fd, NULL);
+		cache_send(STDOUT_FILENO, fd, off, st.st_size - off);
+		close(fd);
+	}
+	if (fd != -1 && k < count)
+		close(fd);
+	if (k == 0)
+		return (0);
+	snprintf(path, sizeof(path), "%s/%016lx", in->dir, hs[k - 1]);
+	hdr.key = hs[k - 1];
+	if (snap_load(path, prog, &hdr) == -1)
+		err(2, path);
+	in->total = hdr.out_off;
+	return (k);
+}
+
+/**
+ * Flushes the output of an incremental run and snapshots its state.
+
+ * @param in: The output of the run.
+
+ * @param prog: The program, stopped at a snapshot position.
+
+ * @param key: The hash of the prefix executed so far.
+
+ * The output printed since the previous snapshot goes to stdout and is
+ * stored after the stack values. A snapshot already on disk for the same
+ * prefix is left alone: the prefix determines the state.
+ */
+static void prefix_save(incr_t *in, program_t *prog, unsigned long key)
+{
+	char path[4096];
+	snap_hdr_t hdr;
+	size_t size;
+
+	fflush(in->out);
+	fwrite(in->obuf, 1, in->olen, stdout);
+	in->total += in->olen;
+	snprintf(path, sizeof(path), "%s/%016lx", in->dir, key);
+	if (prog != NULL && access(path, F_OK) == -1)
+	{
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.key = key;
+		hdr.out_off = in->total;
+		size = snap_pack(prog, &hdr, &in->buf, &in->cap);
+		if (size + in->olen > in->cap)
+		{
+			in->cap = (size + in->olen) * 2;
+			in->buf = realloc(in->buf, in->cap);
+			if (in->buf == NULL)
+				err(4);
+		}
+		memcpy(in->buf + size, in->obuf, in->olen);
+		snap_save(path, in->buf, size + in->olen);
+	}
+	fseeko(in->out, 0, SEEK_SET);
+}
+
+/**
+ * Runs a script, reusing the state reached by an unchanged prefix.
+
+ * @param opts: The options, `incremental` holds the snapshot directory.
+
+ * @return: The exit status of the script.
+
+ * Every `--snapshot-every` instructions (100000 by default), and at the
+ * end, the state of the run is saved under the hash of the instructions
+ * executed so far. The next run of a script sharing that prefix replays
+ * the output stored along the snapshots, restores the last one and only
+ * executes the rest. The directory is trimmed like the output cache, to
+ * `--cache-size` (1G by default).
+ */
+int run_incremental(options_t *opts)
+{
+	program_t prog;
+	incr_t in;
+	unsigned long *hs, limit;
+	size_t count, k;
+	jmp_buf jb;
+	FILE *fd;
+
+	memset(&in, 0, sizeof(in));
+	in.dir = opts->incremental;
+	in.every = opts->snapshot_every ? parse_size(opts->snapshot_every)
+		: 100000;
+	limit = opts->cache_size ? parse_size(opts->cache_size) : 1UL << 30;
+	fd = fopen(opts->file, "r");
+	if (in.every == 0 || fd == NULL)
+		err(in.every == 0 ? 1 : 2, opts->file);
+	load_program(&prog, fd);
+	fclose(fd);
+	hs = prefix_hashes(&prog, in.every, &count);
+	k = prefix_restore(&in, &prog, hs, count);
+	in.out = open_memstream(&in.obuf, &in.olen);
+	if (in.out == NULL)
+		err(4);
+	out_stream = in.out;
+	if (setjmp(jb) != 0)
+	{
+		prefix_save(&in, NULL, 0);
+		return (EXIT_FAILURE);
+	}
+	fail_jmp = &jb;
+	for (; prog.pos < prog.len; k++)
+	{
+		run_steps(&prog, (k + 1) * in.every - prog.pos);
+		prefix_save(&in, &prog, hs[k]);
+	}
+	fail_jmp = NULL;
+	out_stream = stdout;
+	fclose(in.out);
+	free(in.obuf);
+	free(in.buf);
+	free(hs);
+	free_program(&prog);
+	free_nodes();
+	cache_evict(in.dir, limit);
+	return (0);
+}
@@ -0,0 +1,96 @@
+#include "monty.h"
+
+/**
+ * Gives the register instruction a handler lowers to.
+
+ * @param f: The handler.
+
+ * @return: The IR_* code; IR_POP and IR_NOP emit nothing, IR_STACK is any
+ * handler that only runs on the stack.
+ */
+int ir_class(op_func f)
+{
+	static const struct
+	{
+		op_func f;
+		int op;
+	} ops[] = {
+		{push_stack, IR_LI}, {add_nodes, IR_ADD}, {sub_nodes, IR_SUB},
+		{mul_nodes, IR_MUL}, {div_nodes, IR_DIV}, {mod_nodes, IR_MOD},
+		{swap_nodes, IR_SWAP}, {print_top, IR_PINT},
+		{print_char, IR_PCHAR}, {pop_top, IR_POP}, {nop, IR_NOP},
+		{NULL, IR_STACK}
+	};
+	int i;
+
+	for (i = 0; ops[i].f != NULL; i++)
+	{
+		if (ops[i].f == f)
+			break;
+	}
+	return (ops[i].op);
+}
+
+/**
+ * Lowers the next instruction of a program.
+
+ * @param prog: The program.
+
+ * @param c: The instruction, the last one lowered so far.
+
+ * The program has no jumps, so the number of values pushed since the stack
+ * was last built is known at every instruction: those values live in
+ * registers. `push` loads a register, `pop` and `nop` disappear, and the
+ * arithmetic, `swap`, `pint` and `pchar` work on the top registers as long
+ * as there are enough of them. Any other instruction, or one reaching below
+ * the registers, becomes IR_STACK; that includes every `push` of a queue
+ * region, so the registers are on the stack whenever a region ends.
+
+ * The tables give the operands needed, the change of depth and whether
+ * anything is emitted; the instruction is always written and only kept
+ * when it emits something.
+ */
+void ir_add(program_t *prog, code_t *c)
+{
+	static const int need[] = {0, 2, 2, 2, 2, 2, 2, 1, 1, 1 << 30, 1, 0};
+	static const int delta[] = {1, -1, -1, -1, -1, -1, 0, 0, 0, 0, -1, 0};
+	static const int emits[] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0};
+	ir_prog_t *ir = &prog->ir;
+	int k = ir_class(c->f), stack;
+	ir_t *in;
+
+	if (ir->len == ir->size)
+	{
+		ir->size = ir->size == 0 ? 64 : ir->size * 2;
+		in = realloc(ir->ops, ir->size * sizeof(*in));
+		if (in == NULL)
+			err(4);
+		ir->ops = in;
+	}
+	stack = ir->d < need[k];
+	in = &ir->ops[ir->len];
+	in->op = stack ? IR_STACK : k;
+	in->d = ir->d;
+	in->imm = c->n;
+	in->at = c - prog->code;
+	ir->len += stack | emits[k];
+	ir->d = stack ? 0 : ir->d + delta[k];
+	if (ir->d > ir->nregs)
+		ir->nregs = ir->d;
+}
+
+/**
+ * Lowers a whole loaded program again, after `--opt` removed instructions.
+
+ * @param prog: The program.
+ */
+void ir_lower(program_t *prog)
+{
+	size_t i;
+
+	prog->ir.len = 0;
+	prog->ir.d = 0;
+	prog->ir.nregs = 0;
+	for (i = 0; i < prog->len; i++)
+		ir_add(prog, &prog->code[i]);
+}
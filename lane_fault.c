@@ -0,0 +1,81 @@
+#include "monty.h"
+
+/**
+ * Reports an error for a single lane and masks the lane off.
+
+ * @param ls: The lanes.
+
+ * @param lane: The index of the faulting lane.
+
+ * @param error_code: The error code, as for err.
+
+ * The message is the one the interpreter prints for a single run, preceded
+ * by `lane N: `.
+ */
+void lane_fault(lanes_t *ls, size_t lane, int error_code, ...)
+{
+	va_list ag;
+
+	va_start(ag, error_code);
+	fprintf(stderr, "lane %lu: ", (unsigned long)lane);
+	vprint_err(stderr, error_code, ag);
+	va_end(ag);
+	ls->dead[lane] = 1;
+	ls->alive--;
+}
+
+/**
+ * Reports an error for every lane still running and stops them all.
+
+ * @param ls: The lanes.
+
+ * @param error_code: The error code, as for err.
+
+ * @return: 1, so handlers can return it to stop execution.
+
+ * Used for the errors that do not depend on the values of the lanes.
+ */
+int lane_fail(lanes_t *ls, int error_code, ...)
+{
+	va_list ag;
+	char *msg = NULL;
+	size_t len = 0, l;
+	FILE *fp;
+
+	fp = open_memstream(&msg, &len);
+	if (fp == NULL)
+		err(4);
+	va_start(ag, error_code);
+	vprint_err(fp, error_code, ag);
+	va_end(ag);
+	fclose(fp);
+	for (l = 0; l < ls->n; l++)
+	{
+		if (ls->dead[l])
+			continue;
+		fprintf(stderr, "lane %lu: %s", (unsigned long)l, msg);
+		ls->dead[l] = 1;
+	}
+	ls->alive = 0;
+	free(msg);
+	return (1);
+}
+
+/**
+ * Reports an error instruction of the loader in every lane.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction, bad_op, bad_push or a `push` of a value that
+ * does not fit in the int of a lane.
+
+ * @return: 1.
+ */
+int lane_bad(lanes_t *ls, code_t *ins)
+{
+	if (ins->f == push_big_stack || ins->f == push_big_queue)
+		return (lane_fail(ls, 20, ins->ln, "push"));
+	if (ins->f == bad_op)
+		return (lane_fail(ls, 3, ins->ln, ins->op));
+	return (lane_fail(ls, 5, ins->ln));
+}
@@ -0,0 +1,161 @@
+#include "monty.h"
+#include <limits.h>
+
+typedef int lane_half __attribute__((vector_size(16)));
+typedef long lane_wide __attribute__((vector_size(32)));
+typedef double lane_real __attribute__((vector_size(32)));
+#define LANE_WIDE (sizeof(lane_half) / sizeof(int))
+
+/**
+ * Computes `a = a op b` over a vector of lanes, for `add`, `sub` or `mul`.
+
+ * @param a: The lanes of the second row, replaced by the results.
+
+ * @param b: The lanes of the top row.
+
+ * @param op: '+', '-' or '*'.
+
+ * @param bad: Receives, for each lane, 20 if its result does not fit in an
+ * int, else 0.
+
+ * The values are widened to 64 bits, where the operation cannot overflow.
+ * The result fits when its high half only extends the sign of its low one.
+ */
+static void lane_vec(int *a, int *b, int op, lane_half *bad)
+{
+	lane_half h;
+	lane_wide x, y;
+
+	memcpy(&h, a, sizeof(h));
+	x = __builtin_convertvector(h, lane_wide);
+	memcpy(&h, b, sizeof(h));
+	y = __builtin_convertvector(h, lane_wide);
+	if (op == '+')
+		x += y;
+	else if (op == '-')
+		x -= y;
+	else
+		x *= y;
+	h = __builtin_convertvector(x, lane_half);
+	*bad = (__builtin_convertvector(x >> 32, lane_half) != h >> 31) & 20;
+	memcpy(a, &h, sizeof(h));
+}
+
+/**
+ * Computes `a = a op b` over a vector of lanes, for `div` or `mod`.
+
+ * @param a: The lanes of the second row, replaced by the results.
+
+ * @param b: The lanes of the top row.
+
+ * @param op: '/' or '%'.
+
+ * @param bad: Receives, for each lane, 9 if it divides by zero, 20 if it
+ * computes INT_MIN / -1, else 0.
+
+ * Both masks are built first: the lanes dividing by zero divide by 1
+ * instead, and INT_MIN / -1 is computed as 0 / -1, then given INT_MIN as
+ * it would wrap to. There is no integer vector division, so the quotient
+ * is found in doubles, which is exact for 32-bit operands once truncated;
+ * the remainder is then `a - q * b`.
+ */
+static void lane_quot(int *a, int *b, int op, lane_half *bad)
+{
+	lane_half x, y, z, o, q;
+
+	memcpy(&x, a, sizeof(x));
+	memcpy(&y, b, sizeof(y));
+	z = y == 0;
+	y -= z;
+	o = (x == INT_MIN) & (y == -1);
+	x &= ~o;
+	q = __builtin_convertvector(__builtin_convertvector(x, lane_real) /
+		__builtin_convertvector(y, lane_real), lane_half);
+	if (op == '/')
+		x = q | (o & INT_MIN);
+	else
+		x -= q * y;
+	*bad = (z & 9) | (o & (op == '/' ? 20 : 0));
+	memcpy(a, &x, sizeof(x));
+}
+
+/**
+ * Applies `a = a op b` over the two top rows, a vector of lanes at a time.
+
+ * @param ls: The lanes, with at least two rows.
+
+ * @param ins: The instruction.
+
+ * @param op: '+', '-', '*', '/' or '%'.
+
+ * A lane whose result does not fit back in an int faults: outside of lanes
+ * mode the value would be promoted, which the rows of ints cannot hold. So
+ * does a lane dividing by zero. The last lanes are padded with zeros to a
+ * whole vector.
+ */
+static void lane_apply(lanes_t *ls, code_t *ins, int op)
+{
+	int *a = LANE_ROW(ls, 1), *b = LANE_ROW(ls, 0), *pa, *pb;
+	int ta[LANE_WIDE], tb[LANE_WIDE];
+	lane_half bad;
+	size_t l, k, w;
+
+	for (l = 0; l < ls->n; l += LANE_WIDE)
+	{
+		w = ls->n - l < LANE_WIDE ? ls->n - l : LANE_WIDE;
+		pa = a + l;
+		pb = b + l;
+		if (w < LANE_WIDE)
+		{
+			memset(ta, 0, sizeof(ta));
+			memset(tb, 0, sizeof(tb));
+			pa = memcpy(ta, pa, w * sizeof(int));
+			pb = memcpy(tb, pb, w * sizeof(int));
+		}
+		if (op == '/' || op == '%')
+			lane_quot(pa, pb, op, &bad);
+		else
+			lane_vec(pa, pb, op, &bad);
+		if (pa == ta)
+			memcpy(a + l, ta, w * sizeof(int));
+		if ((bad[0] | bad[1] | bad[2] | bad[3]) == 0)
+			continue;
+		for (k = 0; k < w; k++)
+		{
+			if (bad[k] && !ls->dead[l + k])
+				lane_fault(ls, l + k, bad[k], ins->ln, ins->op);
+		}
+	}
+}
+
+/**
+ * Runs `add`, `sub`, `mul`, `div` or `mod` on the two top rows of the
+ * lanes stack.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction.
+
+ * @return: 0 on success, 1 if the stack is too short or every lane faulted.
+ */
+int lane_arith(lanes_t *ls, code_t *ins)
+{
+	static const struct
+	{
+		op_func f;
+		int op;
+	} ops[] = {
+		{add_nodes, '+'}, {sub_nodes, '-'}, {mul_nodes, '*'},
+		{div_nodes, '/'}, {mod_nodes, '%'}
+	};
+	int i;
+
+	for (i = 0; i < 4 && ops[i].f != ins->f; i++)
+		;
+	if (ls->depth < 2)
+		return (lane_fail(ls, 8, ins->ln, ins->op));
+	lane_apply(ls, ins, ops[i].op);
+	if (ls->alive == 0)
+		return (1);
+	return (lane_pop(ls, ins));
+}
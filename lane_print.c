@@ -0,0 +1,128 @@
+#include "monty.h"
+
+/**
+ * Prints the top row of the lanes stack, one value per lane.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction.
+
+ * @return: 0 on success, 1 if the stack is empty.
+ */
+int lane_pint(lanes_t *ls, code_t *ins)
+{
+	int *row;
+	size_t l;
+
+	if (ls->depth == 0)
+		return (lane_fail(ls, 6, ins->ln));
+	row = LANE_ROW(ls, 0);
+	for (l = 0; l < ls->n; l++)
+	{
+		if (!ls->dead[l])
+			fprintf(ls->out[l], "%d\n", row[l]);
+	}
+	return (0);
+}
+
+/**
+ * Prints the whole stack of every lane, from the top.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction (unused).
+
+ * @return: 0, pall cannot fail.
+ */
+int lane_pall(lanes_t *ls, code_t *ins)
+{
+	size_t l, i;
+
+	(void)ins;
+	for (l = 0; l < ls->n; l++)
+	{
+		if (ls->dead[l])
+			continue;
+		for (i = 0; i < ls->depth; i++)
+			fprintf(ls->out[l], "%d\n", LANE_ROW(ls, i)[l]);
+	}
+	return (0);
+}
+
+/**
+ * Prints the top value of every lane as a character.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction.
+
+ * @return: 0 on success, 1 if the stack is empty or every lane faulted.
+
+ * Lanes whose value is not an ASCII character are masked off.
+ */
+int lane_pchar(lanes_t *ls, code_t *ins)
+{
+	int *row;
+	size_t l;
+
+	if (ls->depth == 0)
+		return (lane_fail(ls, 11, ins->ln));
+	row = LANE_ROW(ls, 0);
+	for (l = 0; l < ls->n; l++)
+	{
+		if (ls->dead[l])
+			continue;
+		if (row[l] < 0 || row[l] > 127)
+			lane_fault(ls, l, 10, ins->ln);
+		else
+			fprintf(ls->out[l], "%c\n", row[l]);
+	}
+	return (ls->alive == 0);
+}
+
+/**
+ * Prints the stack of every lane as a string, from the top.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction (unused).
+
+ * @return: 0, pstr cannot fail.
+ */
+int lane_pstr(lanes_t *ls, code_t *ins)
+{
+	size_t l, i;
+	int c;
+
+	(void)ins;
+	for (l = 0; l < ls->n; l++)
+	{
+		if (ls->dead[l])
+			continue;
+		for (i = 0; i < ls->depth; i++)
+		{
+			c = LANE_ROW(ls, i)[l];
+			if (c <= 0 || c > 127)
+				break;
+			fputc(c, ls->out[l]);
+		}
+		fputc('\n', ls->out[l]);
+	}
+	return (0);
+}
+
+/**
+ * Does nothing in every lane.
+
+ * @param ls: The lanes (unused).
+
+ * @param ins: The instruction (unused).
+
+ * @return: 0.
+ */
+int lane_nop(lanes_t *ls, code_t *ins)
+{
+	(void)ls;
+	(void)ins;
+	return (0);
+}
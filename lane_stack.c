@@ -0,0 +1,148 @@
+#include "monty.h"
+
+/**
+ * Adds a row at the top or the bottom of the lanes stack.
+
+ * @param ls: The lanes.
+
+ * @param bottom: 0 to add the row on top, 1 to add it at the bottom.
+
+ * @return: The new row, its values are left for the caller to set.
+
+ * When the ring is full it is reallocated twice as large, with the top row
+ * moved back to index 0.
+ */
+int *lane_grow(lanes_t *ls, int bottom)
+{
+	int *rows;
+	size_t i;
+
+	if (ls->depth == ls->cap)
+	{
+		rows = malloc(ls->cap * 2 * ls->n * sizeof(int));
+		if (rows == NULL)
+			err(4);
+		for (i = 0; i < ls->depth; i++)
+			memcpy(rows + i * ls->n, LANE_ROW(ls, i), ls->n * sizeof(int));
+		free(ls->rows);
+		ls->rows = rows;
+		ls->cap *= 2;
+		ls->top = 0;
+	}
+	ls->depth++;
+	if (bottom)
+		return (LANE_ROW(ls, ls->depth - 1));
+	ls->top = (ls->top + ls->cap - 1) % ls->cap;
+	return (LANE_ROW(ls, 0));
+}
+
+/**
+ * Pushes the argument of a `push` in every lane.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction; push_queue pushes at the bottom.
+
+ * @return: 0, a push cannot fail.
+ */
+int lane_push(lanes_t *ls, code_t *ins)
+{
+	int *row = lane_grow(ls, ins->f == push_queue);
+	size_t l;
+
+	for (l = 0; l < ls->n; l++)
+		row[l] = ins->n;
+	return (0);
+}
+
+/**
+ * Removes the top row of the lanes stack.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction.
+
+ * @return: 0 on success, 1 if the stack was empty.
+ */
+int lane_pop(lanes_t *ls, code_t *ins)
+{
+	if (ls->depth == 0)
+		return (lane_fail(ls, 7, ins->ln));
+	ls->top = (ls->top + 1) % ls->cap;
+	ls->depth--;
+	return (0);
+}
+
+/**
+ * Swaps the two top rows of the lanes stack.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction.
+
+ * @return: 0 on success, 1 if the stack is too short.
+ */
+int lane_swap(lanes_t *ls, code_t *ins)
+{
+	int *a, *b, tmp;
+	size_t l;
+
+	if (ls->depth < 2)
+		return (lane_fail(ls, 8, ins->ln, "swap"));
+	a = LANE_ROW(ls, 0);
+	b = LANE_ROW(ls, 1);
+	for (l = 0; l < ls->n; l++)
+	{
+		tmp = a[l];
+		a[l] = b[l];
+		b[l] = tmp;
+	}
+	return (0);
+}
+
+/**
+ * Moves the top row of the lanes stack to the bottom.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction (unused).
+
+ * @return: 0, rotations cannot fail.
+
+ * When the ring is full the bottom row is right before the top one and only
+ * the top index moves.
+ */
+int lane_rotl(lanes_t *ls, code_t *ins)
+{
+	(void)ins;
+	if (ls->depth < 2)
+		return (0);
+	if (ls->depth < ls->cap)
+		memcpy(LANE_ROW(ls, ls->depth), LANE_ROW(ls, 0),
+		       ls->n * sizeof(int));
+	ls->top = (ls->top + 1) % ls->cap;
+	return (0);
+}
+
+/**
+ * Moves the bottom row of the lanes stack to the top.
+
+ * @param ls: The lanes.
+
+ * @param ins: The instruction (unused).
+
+ * @return: 0, rotations cannot fail.
+ */
+int lane_rotr(lanes_t *ls, code_t *ins)
+{
+	int *bottom;
+
+	(void)ins;
+	if (ls->depth < 2)
+		return (0);
+	bottom = LANE_ROW(ls, ls->depth - 1);
+	ls->top = (ls->top + ls->cap - 1) % ls->cap;
+	if (ls->depth < ls->cap)
+		memcpy(LANE_ROW(ls, 0), bottom, ls->n * sizeof(int));
+	return (0);
+}
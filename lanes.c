@@ -0,0 +1,188 @@
+#include "monty.h"
+
+/**
+ * Reads the initial stacks of all lanes from a seeds file.
+
+ * @param ls: The lanes to initialize.
+
+ * @param name: The path of the seeds file.
+
+ * Every non-empty line of the file is one lane and lists its initial stack
+ * from the bottom to the top, as a series of `push` would. All lines must
+ * hold the same number of values, since the lanes share one stack depth.
+ */
+static void load_lanes(lanes_t *ls, char *name)
+{
+	FILE *fd = fopen(name, "r");
+	char *buffer = NULL, *tok;
+	size_t len = 0, count = 0, size = 0, width = 0, i;
+	int *vals = NULL, line, n;
+
+	if (fd == NULL)
+		err(2, name);
+	for (line = 1; getline(&buffer, &len, fd) != -1; line++)
+	{
+		for (i = 0, tok = strtok(buffer, " \t\n"); tok != NULL;
+		     i++, tok = strtok(NULL, " \t\n"))
+		{
+			if (count == size)
+			{
+				size = size == 0 ? 1024 : size * 2;
+				vals = realloc(vals, size * sizeof(int));
+				if (vals == NULL)
+					err(4);
+			}
+			if (parse_push(tok, &n))
+				err(5, line);
+			vals[count++] = n;
+		}
+		if (i > 0 && ls->n++ == 0)
+			width = i;
+		if (i > 0 && i != width)
+			more_err(12, name, line, (int)width);
+	}
+	free(buffer);
+	fclose(fd);
+	ls->depth = width;
+	ls->cap = width < 8 ? 8 : width;
+	ls->rows = malloc(ls->cap * ls->n * sizeof(int) + 1);
+	if (ls->rows == NULL)
+		err(4);
+	for (i = 0; i < count; i++)
+		LANE_ROW(ls, width - 1 - i % width)[i / width] = vals[i];
+	free(vals);
+}
+
+/**
+ * Allocates the per-lane state once the number of lanes is known.
+
+ * @param ls: The lanes to set up.
+ */
+static void open_lanes(lanes_t *ls)
+{
+	size_t l;
+
+	ls->alive = ls->n;
+	ls->dead = calloc(ls->n, 1);
+	ls->out = malloc(ls->n * sizeof(FILE *));
+	ls->buf = calloc(ls->n, sizeof(char *));
+	ls->size = calloc(ls->n, sizeof(size_t));
+	if (ls->dead == NULL || ls->out == NULL || ls->buf == NULL ||
+	    ls->size == NULL)
+		err(4);
+	for (l = 0; l < ls->n; l++)
+	{
+		ls->out[l] = open_memstream(&ls->buf[l], &ls->size[l]);
+		if (ls->out[l] == NULL)
+			err(4);
+	}
+}
+
+/**
+ * Writes the output of every lane to stdout, in lane order, and frees the lanes.
+
+ * @param ls: The lanes to report.
+
+ * The output of each lane is preceded by a `==> lane N <==` header line.
+ */
+static void close_lanes(lanes_t *ls)
+{
+	size_t l;
+
+	for (l = 0; l < ls->n; l++)
+	{
+		fclose(ls->out[l]);
+		printf("==> lane %lu <==\n", (unsigned long)l);
+		fwrite(ls->buf[l], 1, ls->size[l], stdout);
+		free(ls->buf[l]);
+	}
+	free(ls->rows);
+	free(ls->dead);
+	free(ls->out);
+	free(ls->buf);
+	free(ls->size);
+}
+
+/**
+ * Runs one program once over many independent initial stacks.
+
+ * @param seeds: The path of the seeds file, one initial stack per line.
+
+ * @param file_name: The path of the monty program.
+
+ * @return: EXIT_SUCCESS if no lane faulted, EXIT_FAILURE otherwise.
+
+ * Each instruction is executed for all lanes at once. A lane that faults on
+ * its own values (division by zero, pchar out of range) is reported on
+ * stderr as `lane N: <message>` and masked off; errors that do not depend on
+ * the values (unknown instruction, stack too short) stop every lane.
+ */
+int run_lanes(char *seeds, char *file_name)
+{
+	lanes_t ls;
+	program_t prog;
+	lane_func *funcs;
+	FILE *fd;
+	size_t i;
+
+	memset(&ls, 0, sizeof(ls));
+	fd = fopen(file_name, "r");
+	if (fd == NULL)
+		err(2, file_name);
+	load_program(&prog, fd);
+	fclose(fd);
+	load_lanes(&ls, seeds);
+	open_lanes(&ls);
+	funcs = malloc((prog.len + 1) * sizeof(lane_func));
+	if (funcs == NULL)
+		err(4);
+	for (i = 0; i < prog.len; i++)
+		funcs[i] = find_lane_func(prog.code[i].f);
+	for (i = 0; i < prog.len && ls.alive > 0; i++)
+	{
+		pc = &prog.code[i];
+		if (funcs[i] == NULL ? lane_fail(&ls, 13, pc->ln, pc->op)
+		    : funcs[i](&ls, pc))
+			break;
+	}
+	i = ls.alive;
+	close_lanes(&ls);
+	free(funcs);
+	free_program(&prog);
+	return (i == ls.n ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/**
+ * Finds the lanes version of an instruction handler.
+
+ * @param f: The handler the loader resolved for the instruction.
+
+ * @return: The matching lanes handler, or NULL if the instruction has none.
+ */
+lane_func find_lane_func(op_func f)
+{
+	static const struct
+	{
+		op_func f;
+		lane_func lf;
+	} lane_list[] = {
+		{push_stack, lane_push}, {push_queue, lane_push},
+		{print_stack, lane_pall}, {print_top, lane_pint},
+		{pop_top, lane_pop}, {nop, lane_nop}, {swap_nodes, lane_swap},
+		{add_nodes, lane_arith}, {sub_nodes, lane_arith},
+		{div_nodes, lane_arith}, {mul_nodes, lane_arith},
+		{mod_nodes, lane_arith}, {print_char, lane_pchar},
+		{print_str, lane_pstr}, {rotl, lane_rotl}, {rotr, lane_rotr},
+		{bad_op, lane_bad}, {bad_push, lane_bad},
+		{push_big_stack, lane_bad}, {push_big_queue, lane_bad},
+		{NULL, NULL}
+	};
+	int i;
+
+	for (i = 0; lane_list[i].f != NULL; i++)
+	{
+		if (lane_list[i].f == f)
+			return (lane_list[i].lf);
+	}
+	return (NULL);
+}
@@ -1,5 +1,11 @@
 #include "monty.h"
 stack_t *head = NULL;
+code_t *pc = NULL;
+FILE *out_stream = NULL;
+FILE *err_stream = NULL;
+jmp_buf *fail_jmp = NULL;
+int optimize;
+int lower_ir;
 
 /**
  * Entry point for the program that [briefly describe its purpose].
@@ -19,12 +25,32 @@ stack_t *head = NULL;
 
 int main(int argc, char *argv[])
 {
-	if (argc != 2)
-	{
-		fprintf(stderr, "USAGE: monty file\n");
-		exit(EXIT_FAILURE);
-	}
-	open_file(argv[1]);
+	options_t opts;
+
+	out_stream = stdout;
+	err_stream = stderr;
+	parse_opts(argc, argv, &opts);
+	optimize = opts.opt != NULL && opts.lanes == NULL;
+	if (opts.spill != NULL)
+		pool_spill(opts.spill, opts.mem_budget);
+	if (opts.bf != NULL)
+		return (run_bf(&opts));
+	if (opts.lanes != NULL)
+		return (run_lanes(opts.lanes, opts.file));
+	if (opts.serve != NULL)
+		return (run_server(&opts));
+	if (opts.sched != NULL)
+		return (run_sched(&opts));
+	if (opts.incremental != NULL)
+		return (run_incremental(&opts));
+	if (opts.checkpoint_every != NULL || opts.resume != NULL)
+		return (run_checkpointed(&opts));
+	if (opts.perf_counters != NULL)
+		return (run_perf(&opts));
+	lower_ir = opts.ir != NULL;
+	if (opts.cache != NULL)
+		return (run_cached(&opts));
+	open_file(opts.file);
 	free_nodes();
 	return (0);
 }
@@ -38,11 +64,11 @@ int main(int argc, char *argv[])
 
  * This function:
 
- * 1. Allocates memory for the entire node structure.
+ * 1. Takes a node from the node pool (see pool_alloc).
  * 2. Initializes the node's data field with the provided `n` value.
  * 3. Sets any other necessary fields within the node (if applicable).
 
- * If memory allocation fails or the provided `n` is invalid, this function returns NULL.
+ * If the pool cannot map more memory, the program exits with `Error: malloc failed`.
 
  * The created node might require further operations like insertion into the data structure depending on your program logic.
 
@@ -51,35 +77,49 @@ stack_t *create_node(int n)
 {
 	stack_t *node;
 
-	node = malloc(sizeof(stack_t));
-	if (node == NULL)
-		err(4);
+	node = pool_alloc();
 	node->next = NULL;
 	node->prev = NULL;
 	node->n = n;
+	node->tag = TAG_INT;
 	return (node);
 }
 
 /**
  * Frees all nodes currently present in the stack.
 
- * This function iterates through the stack and releases the memory allocated for each node.
- * After completing the process, the stack will be empty.
-
- * Note: This function assumes proper stack initialization and handling.
+ * Every node comes from the node pool, which is reset as a whole along with
+ * the boxes of large values: the cost does not depend on the size of the
+ * stack. When other stacks share the pool (scheduler mode), the nodes and
+ * the boxes of the registers are given back one by one instead.
+ * After completing the process, the stack is empty and the registers are
+ * released.
  */
 void free_nodes(void)
 {
 	stack_t *tmp;
+	int i;
 
-	if (head == NULL)
+	if (!pool.shared)
+	{
+		head = NULL;
+		pool_reset();
+		box_reset();
+		free(regs);
+		regs = NULL;
+		idx_reset();
 		return;
-
+	}
+	for (i = 0; regs != NULL && i < MONTY_REGS; i++)
+		num_set_long(&regs[i], 0);
+	free(regs);
+	regs = NULL;
+	idx_reset();
 	while (head != NULL)
 	{
 		tmp = head;
 		head = head->next;
-		free(tmp);
+		free_node(tmp);
 	}
 }
 
@@ -8,22 +8,34 @@
 #include <stdarg.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#define MONTY_VERSION "1.4"
+
+#define TAG_INT 0
+#define TAG_LONG 1
+#define TAG_BIG 2
 
 /**
  * Structure representing a node in a doubly linked list.
 
  * @field n: The data stored within the node (e.g., integer value, data pointer).
+ * @field tag: TAG_INT when `n` is the value itself; TAG_LONG or TAG_BIG when
+ * `n` is the index of the box holding it (see num_t).
  * @field prev: Pointer to the previous node in the linked list.
  * @field next: Pointer to the next node in the linked list.
 
  * Description: This structure can be used to build both stacks and queues
  * through appropriate manipulation of `prev` and `next` pointers. It supports
  * both LIFO (Last In First Out) and FIFO (First In First Out) access depending
- * on the implementation of the data structure.
+ * on the implementation of the data structure. The tag sits in what was the
+ * padding after `n`, so the node did not grow.
  */
 typedef struct stack_s
 {
         int n;
+        int tag;
         struct stack_s *prev;
         struct stack_s *next;
 } stack_t;
@@ -49,6 +61,288 @@ typedef struct instruction_s
 extern stack_t *head;
 typedef void (*op_func)(stack_t **, unsigned int);
 
+#define POOL_SEG (16UL << 20)
+#define POOL_NODES (POOL_SEG / sizeof(stack_t))
+#define POOL_WALK 0xffff
+#define POOL_CODE (1UL << 20)
+#define POOL_CODE_LEN (POOL_CODE / sizeof(code_t))
+
+/**
+ * Structure representing the memory the stack nodes are allocated from.
+
+ * @field segs: The mapped segments, POOL_SEG bytes each.
+ * @field nsegs: The number of mapped segments.
+ * @field ssize: The allocated capacity of `segs`.
+ * @field cur: Index of the segment nodes are currently carved from.
+ * @field used: The number of nodes already carved from segment `cur`.
+ * @field free: The freed nodes, linked through `next`, reused first.
+ * @field spill: 1 when the segments are mapped from a file, 0 when anonymous.
+ * @field fd: The spill file.
+ * @field budget: The number of spill segments that may stay resident.
+ * @field tick: For each segment, when it was last used (0 if not resident).
+ * @field clock: The last tick handed out.
+ * @field shared: Set when several stacks live in the pool at once, so
+ * free_nodes must give back the nodes of `head` one by one.
+ * @field cfd: The spill code file, -1 without `--spill`.
+ * @field code: The instructions mapped from `cfd`, NULL when no program
+ * keeps its instructions there.
+ * @field csize: The size of that mapping.
+
+ * Description: Nodes are carved from the end of each segment towards its
+ * start, so walking the stack from the top, newest node first, reads every
+ * segment in increasing address order. With `--spill`, segments live in an
+ * unlinked file and the least recently used ones are written back and
+ * dropped from memory once more than `budget` of them are resident. The
+ * instructions of the running program live in a second file and only the
+ * POOL_CODE bytes around the running one stay resident (see pool_code_run).
+ */
+typedef struct pool_s
+{
+        char **segs;
+        size_t nsegs;
+        size_t ssize;
+        size_t cur;
+        size_t used;
+        stack_t *free;
+        int spill;
+        int fd;
+        size_t budget;
+        unsigned long *tick;
+        unsigned long clock;
+        int shared;
+        int cfd;
+        struct code_s *code;
+        size_t csize;
+} pool_t;
+
+extern pool_t pool;
+
+/**
+ * Structure representing one loaded instruction of a program.
+
+ * @field f: The handler resolved for the opcode when the program was loaded.
+ * @field n: The integer argument of the instruction (`push` and bulk opcodes).
+ * @field n2: The second integer argument of the bulk opcodes taking two.
+ * @field ln: The line number the instruction was read from.
+ * @field op: The opcode text, kept for error messages; for a `push` whose
+ * argument does not fit in an int, the argument itself (see push_big_stack).
+
+ * Description: The loader turns every non-empty line of a file into one of
+ * these entries. Lines that would fail when executed (unknown opcodes, bad
+ * `push` arguments) are loaded as error instructions so that the error is
+ * still reported only when execution reaches that line.
+ */
+typedef struct code_s
+{
+        op_func f;
+        int n;
+        int n2;
+        unsigned int ln;
+        char *op;
+} code_t;
+
+/**
+ * Structure representing a run of instructions sharing one data format.
+
+ * @field start: Index of the first instruction of the region.
+ * @field len: Number of instructions in the region.
+ * @field format: 0 if the region pushes as a stack (LIFO), 1 for a queue (FIFO).
+
+ * Description: The loader starts a new region whenever a `stack` or `queue`
+ * directive changes the format, and resolves every `push` of the region to
+ * the handler for that format, so execution never checks the format.
+ */
+typedef struct region_s
+{
+        size_t start;
+        size_t len;
+        int format;
+} region_t;
+
+#define IR_LI 0
+#define IR_ADD 1
+#define IR_SUB 2
+#define IR_MUL 3
+#define IR_DIV 4
+#define IR_MOD 5
+#define IR_SWAP 6
+#define IR_PINT 7
+#define IR_PCHAR 8
+#define IR_STACK 9
+#define IR_POP 10
+#define IR_NOP 11
+
+/**
+ * Structure representing one instruction of the register backend.
+
+ * @field op: One of the IR_* codes up to IR_STACK.
+ * @field d: The number of registers holding values before the instruction.
+ * @field imm: The value loaded by IR_LI.
+ * @field at: The index of the instruction of the program it comes from.
+
+ * Description: Register `i` holds the value `i` slots above the part of the
+ * stack that is really built, so the registers in use are always 0 to
+ * `d - 1`, the last one on top, and the depth names the operands: IR_LI
+ * loads register `d`, the arithmetic sets register `d - 2` from registers
+ * `d - 2` and `d - 1`, IR_SWAP exchanges them, IR_PINT and IR_PCHAR print
+ * register `d - 1`. IR_STACK first moves the registers onto the stack, then
+ * runs the instruction `at` on it.
+ */
+typedef struct ir_s
+{
+        int op;
+        int d;
+        int imm;
+        unsigned int at;
+} ir_t;
+
+/**
+ * Structure representing a program lowered to the register backend.
+
+ * @field ops: The instructions.
+ * @field len: The number of instructions.
+ * @field size: The allocated capacity of `ops`.
+ * @field d: The number of registers in use after the last instruction.
+ * @field nregs: The number of registers used.
+ */
+typedef struct ir_prog_s
+{
+        ir_t *ops;
+        size_t len;
+        size_t size;
+        int d;
+        int nregs;
+} ir_prog_t;
+
+/**
+ * Structure representing a whole loaded program.
+
+ * @field code: The instructions, in file order.
+ * @field len: The number of instructions in `code`.
+ * @field size: The allocated capacity of `code`.
+ * @field regions: The format regions covering `code`, in order.
+ * @field nregions: The number of regions.
+ * @field rsize: The allocated capacity of `regions`.
+ * @field pos: Index of the next instruction to execute.
+ * @field reg: Index of the region holding `pos`.
+ * @field ir: With `--ir`, the program lowered as it is loaded (see ir_add).
+ */
+typedef struct program_s
+{
+        code_t *code;
+        size_t len;
+        size_t size;
+        region_t *regions;
+        size_t nregions;
+        size_t rsize;
+        size_t pos;
+        size_t reg;
+        ir_prog_t ir;
+} program_t;
+
+#define MONTY_REGS 256
+
+extern code_t *pc;
+extern stack_t *regs;
+extern FILE *out_stream;
+extern FILE *err_stream;
+extern jmp_buf *fail_jmp;
+extern int optimize;
+extern int lower_ir;
+
+/**
+ * Structure holding the command line options.
+
+ * @field file: The monty program to run.
+ * @field lanes: `--lanes seeds`: the seeds file of a lanes run.
+ * @field cache: `--cache dir`: the directory of the output cache.
+ * @field cache_size: `--cache-size bytes`: the size limit of the cache.
+ * @field spill: `--spill dir`: keep the stack in a file created in `dir`.
+ * @field mem_budget: `--mem-budget bytes`: how much of it stays in memory.
+ * @field serve: `--serve socket`: run as a server on a Unix socket.
+ * @field workers: `--workers n`: the number of requests served at once.
+ * @field budget: `--budget n`: the instruction budget of each request.
+ * @field sched: `--sched`: `file` lists scripts to run side by side.
+ * @field quantum: `--quantum n`: the instructions a script runs per turn.
+ * @field stats: `--stats`: print scheduler statistics on stderr.
+ * @field opt: `--opt`: remove instructions that cannot affect the output.
+ * @field checkpoint_every: `--checkpoint-every n`: instructions between checkpoints.
+ * @field checkpoint: `--checkpoint path`: where checkpoints are written.
+ * @field resume: `--resume path`: the checkpoint to continue from.
+ * @field incremental: `--incremental dir`: where prefix snapshots are kept.
+ * @field snapshot_every: `--snapshot-every n`: instructions between them.
+ * @field bf: `--bf`: the file is a Brainfuck program.
+ * @field tape_size: `--tape-size n`: the number of cells of its tape.
+ * @field ir: `--ir`: run the program on the register backend (see run_ir).
+ * @field perf_counters: `--perf-counters`: count hardware events by opcode.
+
+ * Description: Every option is kept as given on the command line, NULL when
+ * absent; options without an argument are set to an empty string.
+ */
+typedef struct options_s
+{
+        char *file;
+        char *lanes;
+        char *cache;
+        char *cache_size;
+        char *spill;
+        char *mem_budget;
+        char *serve;
+        char *workers;
+        char *budget;
+        char *sched;
+        char *quantum;
+        char *stats;
+        char *opt;
+        char *checkpoint_every;
+        char *checkpoint;
+        char *resume;
+        char *incremental;
+        char *snapshot_every;
+        char *bf;
+        char *tape_size;
+        char *ir;
+        char *perf_counters;
+} options_t;
+
+/**
+ * Structure representing the stacks of all lanes of a `--lanes` run.
+
+ * @field n: The number of lanes.
+ * @field rows: The stack, one row of `n` values per stack position.
+ * @field cap: The number of rows allocated in `rows`.
+ * @field top: Index in `rows` of the row holding the top of the stack.
+ * @field depth: The number of rows in use.
+ * @field dead: One flag per lane, set once the lane has faulted.
+ * @field alive: The number of lanes that did not fault.
+ * @field out: One output stream per lane.
+ * @field buf: The buffers behind `out`.
+ * @field size: The sizes of the buffers behind `out`.
+
+ * Description: The rows form a ring so that pushes at either end and
+ * rotations do not move the other rows. The stack depth does not depend on
+ * the values, so every lane always has the same depth and one row per
+ * position is enough; arithmetic then works on whole rows at once.
+ */
+typedef struct lanes_s
+{
+        size_t n;
+        int *rows;
+        size_t cap;
+        size_t top;
+        size_t depth;
+        char *dead;
+        size_t alive;
+        FILE **out;
+        char **buf;
+        size_t *size;
+} lanes_t;
+
+typedef int (*lane_func)(lanes_t *, code_t *);
+
+#define LANE_ROW(ls, i) \
+	((ls)->rows + (((ls)->top + (i)) % (ls)->cap) * (ls)->n)
+
 /*String operations*/
 void rotl(stack_t **, unsigned int);
 void print_str(stack_t **, unsigned int);
@@ -56,6 +350,7 @@ void print_char(stack_t **, unsigned int);
 
 /*Stack operations*/
 stack_t *create_node(int n);
+void free_node(stack_t *node);
 void free_nodes(void);
 void add_to_queue(stack_t **, unsigned int);
 void add_to_stack(stack_t **, unsigned int);
@@ -63,18 +358,583 @@ void print_stack(stack_t **, unsigned int);
 
 /*file operations*/
 void open_file(char *file_name);
-void find_func(char *, char *, int, int);
+op_func find_func(char *, int, char **);
 void read_file(FILE *);
 int len_chars(FILE *);
-int parse_line(char *buffer, int line_number, int format);
+void parse_line(program_t *prog, char *buffer, int line_number);
+
+/*Program loading and execution*/
+void load_program(program_t *prog, FILE *fd);
+code_t *add_code(program_t *prog, op_func f, int n, int ln, char *op);
+void set_format(program_t *prog, int format);
+void run_program(program_t *prog);
+size_t run_steps(program_t *prog, size_t limit);
+void die(void);
+void free_program(program_t *prog);
+size_t compact_program(program_t *prog, char *keep);
+
+/*Instructions resolved by the loader*/
+void push_stack(stack_t **, unsigned int);
+void push_queue(stack_t **, unsigned int);
+void push_big_stack(stack_t **, unsigned int);
+void push_big_queue(stack_t **, unsigned int);
+void bad_op(stack_t **, unsigned int);
+void bad_push(stack_t **, unsigned int);
+
+/*Bulk operations*/
+int bulk_args(op_func f, char *val, char *val2, code_t *code);
+void bad_bulk(stack_t **, unsigned int);
+unsigned int *bulk_buffer(size_t n);
+unsigned int *bulk_gather(size_t *n, char *op);
+void bulk_drop(size_t n);
+void bulk_scatter(unsigned int *v, size_t n);
+long bulk_sum(unsigned int *v, size_t n);
+int bulk_scale(unsigned int *v, size_t n, int mul, int add);
+void bulk_iota(unsigned int *v, size_t n, unsigned int start, unsigned int step);
+void bulk_reverse(unsigned int *v, size_t n);
+void sum_nodes(stack_t **, unsigned int);
+void prod_nodes(stack_t **, unsigned int);
+void rev_nodes(stack_t **, unsigned int);
+void sort_nodes(stack_t **, unsigned int);
+void addc_nodes(stack_t **, unsigned int);
+void mulc_nodes(stack_t **, unsigned int);
+void range_stack(stack_t **, unsigned int);
+void range_queue(stack_t **, unsigned int);
+void bulk_fold(size_t n, int op);
+void bulk_scale_nodes(size_t n, int mul, int add);
+void bulk_rev_nodes(size_t n);
+void bulk_sort_nodes(size_t n);
+
+#define IDX_BLK 256
+#define IDX_MIN 64
+
+/**
+ * Structure representing the index of the stack used by deep `pick`/`roll`.
+
+ * @field blk: The blocks, bottom of the stack first, of IDX_BLK nodes each;
+ * a block holds its nodes from its start, bottom first.
+ * @field cnt: The number of nodes in each block.
+ * @field fen: A Fenwick tree over `cnt` (1-based), to find the block
+ * holding a depth in O(log n).
+ * @field nblk: The number of blocks in use; the last one is never empty.
+ * @field cap: The number of blocks `fen` covers, a power of two.
+ * @field len: The number of nodes indexed.
+ * @field at: The first instruction whose effect the index does not show
+ * yet, NULL when it must be rebuilt.
+ * @field tmp: Scratch space for the nodes pushed since then.
+ * @field tsize: The capacity of `tmp`.
+
+ * Description: The index is only built by the first `pick` or `roll` at
+ * least IDX_MIN deep, and never with `--spill`, whose budget it would
+ * exceed. Removing a node leaves a hole in its block, so `roll` only moves
+ * the rest of one block. Between two of them, the instructions run are
+ * replayed on the top of the index (see idx_sync).
+ */
+typedef struct stack_idx_s
+{
+        stack_t ***blk;
+        size_t *cnt;
+        size_t *fen;
+        size_t nblk;
+        size_t cap;
+        size_t len;
+        code_t *at;
+        stack_t **tmp;
+        size_t tsize;
+} stack_idx_t;
+
+extern stack_idx_t stack_idx;
+
+/*Registers and indexed access*/
+stack_t *reg_bank(void);
+void store_reg(stack_t **, unsigned int);
+void load_stack(stack_t **, unsigned int);
+void load_queue(stack_t **, unsigned int);
+void pick_nodes(stack_t **, unsigned int);
+void roll_nodes(stack_t **, unsigned int);
+void idx_reset(void);
+int idx_push(stack_t *node);
+void idx_pop(size_t n);
+void idx_shape(size_t n);
+void idx_rebuild(void);
+void idx_remove(size_t b, size_t i);
+stack_t *idx_find(size_t depth, int take);
+void idx_done(stack_t *top);
+
+#define CACHE_MAGIC "MONTYC3"
+#define CACHE_OPT 1
+#define CACHE_IR 2
+#define CACHE_TTY 4
+
+/**
+ * Structure representing the header of an output cache entry.
+
+ * @field magic: CACHE_MAGIC, identifies an entry.
+ * @field key: The content hash of the interpreter version and the script.
+ * @field src_len: The size of the script, stored right after stderr.
+ * @field out_len: The size of the stdout bytes, right after the header.
+ * @field err_len: The size of the stderr records, right after stdout: the
+ * stdout bytes written before them, their length, then their bytes.
+ * @field status: The exit status of the run.
+ * @field flags: The options the run depends on, CACHE_OPT, CACHE_IR and
+ * CACHE_TTY, also hashed into the key.
+
+ * Description: An entry is a single file named after the hex key of the
+ * script and the options. The script itself is stored last and compared
+ * on every hit, so two scripts with the same key never share an entry. Its
+ * modification time is refreshed on every hit, so the oldest entries are
+ * the least recently used ones when the cache is trimmed.
+ */
+typedef struct cache_hdr_s
+{
+        char magic[8];
+        unsigned long key;
+        unsigned long src_len;
+        unsigned long out_len;
+        unsigned long err_len;
+        int status;
+        int flags;
+} cache_hdr_t;
+
+/*Server mode*/
+#define SERVE_PATH ((size_t)-1)
+
+int run_server(options_t *opts);
+int serve_request(char *req, size_t len, size_t budget, FILE *out,
+		  FILE *errs);
+
+/**
+ * Structure representing the state of a script while the scheduler runs it.
+
+ * @field prog: The loaded script, with its position.
+ * @field head: The top of the stack of the script while it is switched out.
+ * @field out: The stream buffering what the script prints.
+ * @field errs: The stream buffering its error message, if any.
+ * @field obuf: The buffer behind `out`.
+ * @field olen: The size of `obuf`.
+ * @field ebuf: The buffer behind `errs`.
+ * @field elen: The size of `ebuf`.
+ * @field regs: The registers of the script, NULL until its first `store`.
+ */
+typedef struct task_state_s
+{
+        program_t prog;
+        stack_t *head;
+        FILE *out;
+        FILE *errs;
+        char *obuf;
+        size_t olen;
+        char *ebuf;
+        size_t elen;
+        stack_t *regs;
+} task_state_t;
+
+/**
+ * Structure representing one script run by the scheduler.
+
+ * @field name: The path of the script.
+ * @field run: Its state, NULL until its first turn and once it ended.
+ * @field steps: The number of instructions executed so far.
+ * @field quanta: The number of turns the script had.
+ * @field wait: The instructions executed by other scripts while it waited.
+ * @field last: The scheduler clock at the end of its last turn.
+
+ * Description: A task waiting for its first turn is only its name, so a
+ * long list of scripts costs little more than the list itself.
+ */
+typedef struct task_s
+{
+        char *name;
+        task_state_t *run;
+        unsigned long steps;
+        unsigned long quanta;
+        unsigned long wait;
+        unsigned long last;
+} task_t;
+
+/*Scheduler mode*/
+int run_sched(options_t *opts);
+task_t *sched_load(char *list, size_t *count);
+void sched_start(task_t *t);
+
+#define SNAP_MAGIC "MONTYS3"
+
+/**
+ * Structure representing the header of a snapshot of a running program.
+
+ * @field magic: SNAP_MAGIC, identifies a snapshot.
+ * @field key: The hash of the program the snapshot was taken from.
+ * @field pos: Index of the next instruction to execute.
+ * @field depth: The number of stack values following the header, top first.
+ * @field words: The number of ints holding the stack values and registers.
+ * @field out_off: The offset of stdout when the snapshot was taken, or -1
+ * if stdout could not seek.
+ * @field format: The format (0 stack, 1 queue) of the region holding `pos`.
+ * @field pad: Unused, keeps the header size fixed.
+
+ * Description: A snapshot is the header followed by the stack values and
+ * then the registers, packed by num_pack, so it can be written with a
+ * single write from one buffer.
+ */
+typedef struct snap_hdr_s
+{
+        char magic[8];
+        unsigned long key;
+        unsigned long pos;
+        unsigned long depth;
+        unsigned long words;
+        long out_off;
+        int format;
+        int pad;
+} snap_hdr_t;
+
+/*Snapshots*/
+unsigned long code_hash(unsigned long h, code_t *code, int format);
+unsigned long prog_key(program_t *prog);
+size_t snap_pack(program_t *prog, snap_hdr_t *hdr, char **buf, size_t *cap);
+int snap_save(char *path, char *buf, size_t size);
+int snap_load(char *path, program_t *prog, snap_hdr_t *hdr);
+int run_checkpointed(options_t *opts);
+
+/**
+ * Structure representing the output of an incremental run.
+
+ * @field dir: The directory holding the prefix snapshots.
+ * @field every: The number of instructions between two snapshots.
+ * @field out: The stream the script prints to, flushed at every snapshot.
+ * @field obuf: The buffer behind `out`.
+ * @field olen: The size of `obuf`.
+ * @field total: The number of bytes printed so far.
+ * @field buf: The buffer snapshots are laid out in.
+ * @field cap: The allocated size of `buf`.
+ */
+typedef struct incr_s
+{
+        char *dir;
+        size_t every;
+        FILE *out;
+        char *obuf;
+        size_t olen;
+        long total;
+        char *buf;
+        size_t cap;
+} incr_t;
+
+int run_incremental(options_t *opts);
+
+/**
+ * Structure representing a value of the stack during the analysis of --opt.
+
+ * @field web: The web the value belongs to.
+ * @field birth: When the value was pushed or computed (instruction index + 1).
+ */
+typedef struct dce_value_s
+{
+        size_t web;
+        size_t birth;
+} dce_value_t;
+
+#define DCE_KEEP ((size_t)-1)
+#define DCE_DROP ((size_t)-2)
+
+/**
+ * Structure representing the state of the dead computation analysis.
+
+ * @field parent: The union-find forest of the webs.
+ * @field live: For each web root, whether the web affects the output.
+ * @field nwebs: The number of webs created.
+ * @field web: For each instruction, its web, DCE_KEEP or DCE_DROP.
+ * @field vals: The stack of values, a ring of `cap` entries.
+ * @field cap: The allocated size of `vals`.
+ * @field front: Index in `vals` of the top of the stack.
+ * @field depth: The number of values on the stack.
+ * @field last_all: When an instruction last looked at the whole stack.
+
+ * Description: A web groups the instructions that produce, combine or drop
+ * the same values. Every instruction of a web can be removed at once when
+ * none of its values is printed or can cause an error.
+ */
+typedef struct dce_s
+{
+        size_t *parent;
+        char *live;
+        size_t nwebs;
+        size_t *web;
+        dce_value_t *vals;
+        size_t cap;
+        size_t front;
+        size_t depth;
+        size_t last_all;
+} dce_t;
+
+/*Dead computation elimination*/
+void dce_program(program_t *prog);
+size_t web_find(dce_t *d, size_t w);
+size_t web_union(dce_t *d, size_t a, size_t b);
+void val_push(dce_t *d, size_t web, size_t birth, int bottom);
+dce_value_t val_pop(dce_t *d);
+
+/*Register backend*/
+int ir_class(op_func f);
+void ir_add(program_t *prog, code_t *c);
+void ir_lower(program_t *prog);
+void run_ir(program_t *prog);
+
+#define PERF_EVENTS 5
+#define PERF_OPS 64
+#define PERF_PERIOD 64
+
+/**
+ * Structure representing the counts of one opcode in a `--perf-counters` run.
+
+ * @field name: The opcode.
+ * @field count: The number of times it ran.
+ * @field samples: The number of those runs that were measured.
+ * @field sum: For each counter, its total over the measured runs.
+ */
+typedef struct perf_op_s
+{
+        char *name;
+        unsigned long count;
+        unsigned long samples;
+        unsigned long sum[PERF_EVENTS];
+} perf_op_t;
+
+/**
+ * Structure representing the counters of a `--perf-counters` run.
+
+ * @field fd: The counter leading the group, -1 when none could be opened.
+ * @field fds: Each counter, -1 when it is not available.
+ * @field slot: Where each counter is in a read of the group, -1 if absent.
+ * @field names: The name of each counter.
+ * @field nopen: The number of counters opened.
+ * @field errs: The errno of each counter that could not be opened, 0 for
+ * the others.
+ * @field base: For each counter, what two reads in a row count, taken off
+ * every sample.
+ * @field start: The counters when the program started.
+ * @field total: The counters over the whole run.
+ * @field enabled: The time the group was enabled, in ns, at the last read.
+ * @field running: The time it was counting; less than `enabled` when the
+ * kernel multiplexed the counters.
+ * @field seed: The state of the generator of the gaps between samples.
+ * @field ops: The counts of each opcode.
+ * @field nops: The number of opcodes in `ops`.
+ * @field last: The index in `ops` of the last opcode looked up.
+ */
+typedef struct perf_s
+{
+        int fd;
+        int fds[PERF_EVENTS];
+        int slot[PERF_EVENTS];
+        char *names[PERF_EVENTS];
+        int nopen;
+        int errs[PERF_EVENTS];
+        unsigned long base[PERF_EVENTS];
+        unsigned long start[PERF_EVENTS];
+        unsigned long total[PERF_EVENTS];
+        unsigned long enabled;
+        unsigned long running;
+        unsigned long seed;
+        perf_op_t ops[PERF_OPS];
+        size_t nops;
+        size_t last;
+} perf_t;
+
+/*Hardware counters*/
+void perf_open(perf_t *p);
+int perf_read(perf_t *p, unsigned long *v);
+void perf_calibrate(perf_t *p);
+void perf_close(perf_t *p);
+perf_op_t *perf_entry(perf_t *p, code_t *c);
+void perf_report(perf_t *p, program_t *prog, size_t done);
+int run_perf(options_t *opts);
+
+#define PALL_CHUNK (1UL << 16)
+#define PALL_MIN (4 * PALL_CHUNK)
+
+/**
+ * Structure representing a large `pall` formatted by several threads.
+
+ * @field starts: The first node of every range of PALL_CHUNK nodes.
+ * @field nranges: The number of ranges.
+ * @field tail: The number of nodes in the last range.
+ * @field next: The next range to format, shared by the threads.
+ * @field end: The range after the last one of the current round.
+ * @field bufs: One output buffer per range of a round.
+ * @field lens: The number of bytes formatted in each buffer.
+ * @field slots: The number of ranges in a round.
+ */
+typedef struct pall_job_s
+{
+        stack_t **starts;
+        size_t nranges;
+        size_t tail;
+        size_t next;
+        size_t end;
+        char **bufs;
+        size_t *lens;
+        size_t slots;
+} pall_job_t;
+
+int pall_parallel(stack_t *top);
+
+#define BF_TAPE 30000
+#define BF_CLEAR 'z'
+#define BF_SCAN_R 'R'
+#define BF_SCAN_L 'L'
+
+/**
+ * Structure representing one instruction of a compiled Brainfuck program.
+
+ * @field op: One of `+>[].,`, BF_CLEAR (`[-]`), BF_SCAN_R (`[>]`) or
+ * BF_SCAN_L (`[<]`).
+ * @field n: What `+` adds to the cell and `>` to the pointer (a run of
+ * `-` or `<` is negative); for `[` and `]`, the index of the other bracket.
+ */
+typedef struct bf_op_s
+{
+        int op;
+        long n;
+} bf_op_t;
+
+/**
+ * Structure representing a compiled Brainfuck program.
+
+ * @field ops: The instructions.
+ * @field count: The number of instructions.
+ * @field cap: The number of instructions allocated.
+ * @field reach: The longest move of the pointer by a single instruction.
+ */
+typedef struct bf_prog_s
+{
+        bf_op_t *ops;
+        size_t count;
+        size_t cap;
+        long reach;
+} bf_prog_t;
+
+void bf_compile(char *src, size_t len, char *name, bf_prog_t *prog);
+int bf_exec(bf_prog_t *prog, unsigned char *tape, size_t size);
+int run_bf(options_t *opts);
+
+/*Node pool*/
+stack_t *pool_alloc(void);
+void pool_reset(void);
+void pool_spill(char *dir, char *budget);
+void pool_touch(size_t seg);
+void pool_walk(stack_t *node);
+code_t *pool_code_grow(code_t *code, size_t size);
+void pool_code_drop(size_t k);
+code_t *pool_code_run(code_t *start, code_t *end);
+void pool_code_free(void);
+
+/*Command line*/
+void parse_opts(int argc, char **argv, options_t *opts);
+unsigned long parse_size(char *str);
+
+/*Output cache*/
+int run_cached(options_t *opts);
+int cache_replay(int fd);
+void cache_send(int out, int fd, off_t off, size_t len);
+int cache_run(char *src, char *dir, cache_hdr_t *hdr, char *tmp);
+void cache_evict(char *dir, unsigned long limit);
+
+/*Lanes mode*/
+int run_lanes(char *seeds, char *file_name);
+lane_func find_lane_func(op_func f);
+void lane_fault(lanes_t *ls, size_t lane, int error_code, ...);
+int lane_fail(lanes_t *ls, int error_code, ...);
+int *lane_grow(lanes_t *ls, int bottom);
+int lane_push(lanes_t *ls, code_t *ins);
+int lane_pop(lanes_t *ls, code_t *ins);
+int lane_swap(lanes_t *ls, code_t *ins);
+int lane_rotl(lanes_t *ls, code_t *ins);
+int lane_rotr(lanes_t *ls, code_t *ins);
+int lane_arith(lanes_t *ls, code_t *ins);
+int lane_nop(lanes_t *ls, code_t *ins);
+int lane_pint(lanes_t *ls, code_t *ins);
+int lane_pall(lanes_t *ls, code_t *ins);
+int lane_pchar(lanes_t *ls, code_t *ins);
+int lane_pstr(lanes_t *ls, code_t *ins);
+int lane_bad(lanes_t *ls, code_t *ins);
 
 /*Error hanlding*/
 void err(int error_code, ...);
+void vprint_err(FILE *fp, int error_code, va_list ag);
+void more_msg(FILE *fp, int error_code, va_list ag);
+void op_msg(FILE *fp, int error_code, va_list ag);
+void bf_msg(FILE *fp, int error_code, va_list ag);
+void spill_msg(FILE *fp, int error_code, va_list ag);
 void rotr(stack_t **, unsigned int);
 void string_err(int error_code, ...);
 void more_err(int error_code, ...);
 
-void call_fun(op_func, char *, char *, int, int);
+int parse_push(char *val, int *n);
+
+/**
+ * Structure representing a value too large for the `n` of a node.
+
+ * @field v: The value of a TAG_LONG box.
+ * @field d: The magnitude of a TAG_BIG box, in base 2^32, lowest limb first.
+ * @field len: The number of limbs in `d`, without leading zeros.
+ * @field cap: The allocated number of limbs in `d`.
+ * @field neg: 1 if the TAG_BIG value is negative.
+ * @field next: The next free box, while the box is on the free list.
+
+ * Description: Boxes live in one growing array and are referred to by their
+ * index, which fits in the `n` of a node. Every value is kept in its
+ * smallest form: an int in the node, then a 64-bit box, then a bignum box.
+ * Each box belongs to exactly one node; copying a value copies its box.
+ */
+typedef struct num_s
+{
+        long v;
+        unsigned int *d;
+        size_t len;
+        size_t cap;
+        int neg;
+        int next;
+} num_t;
+
+/**
+ * Structure representing a signed magnitude during bignum arithmetic.
+
+ * @field d: The limbs, in base 2^32, lowest first.
+ * @field len: The number of limbs, without leading zeros (0 for zero).
+ * @field neg: 1 if the value is negative.
+ */
+typedef struct big_s
+{
+        unsigned int *d;
+        size_t len;
+        int neg;
+} big_t;
+
+extern num_t *boxes;
+
+/*Tagged values*/
+int box_new(void);
+void box_free(int i);
+void box_reset(void);
+void num_copy(stack_t *dst, stack_t *src);
+void num_move(stack_t *dst, stack_t *src);
+void num_view(stack_t *node, big_t *b, unsigned int *buf);
+void num_store(stack_t *node, big_t *b);
+void num_set_long(stack_t *node, long v);
+int num_long(stack_t *node, long *v);
+int mag_cmp(big_t *a, big_t *b);
+void mag_add(big_t *r, big_t *a, big_t *b);
+void mag_sub(big_t *r, big_t *a, big_t *b);
+void mag_mul(big_t *r, big_t *a, big_t *b);
+unsigned int mag_div_small(big_t *q, big_t *a, unsigned int d);
+void mag_divmod(big_t *q, big_t *r, big_t *a, big_t *b);
+void num_arith(stack_t *a, stack_t *b, int op);
+int num_cmp(stack_t *a, stack_t *b);
+void num_print(FILE *fp, stack_t *node);
+void num_parse(stack_t *node, char *s);
+size_t num_pack(stack_t *node, int *out);
+size_t num_unpack(stack_t *node, int *in, size_t avail);
 
 void print_top(stack_t **, unsigned int);
 void pop_top(stack_t **, unsigned int);
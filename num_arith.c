@@ -0,0 +1,115 @@
+#include "monty.h"
+#include <limits.h>
+
+/**
+ * Computes `a = a op b` on bignums.
+
+ * @param a: The node holding the left operand, receiving the result.
+
+ * @param b: The node holding the right operand, not 0 for '/' and '%'.
+
+ * @param op: '+', '-', '*', '/' or '%'.
+
+ * Division truncates towards zero and the remainder has the sign of `a`,
+ * as with C integers.
+ */
+static void big_arith(stack_t *a, stack_t *b, int op)
+{
+	unsigned int xb[2], yb[2], *buf;
+	big_t x, y, q, r, *res = &r;
+	size_t size;
+
+	num_view(a, &x, xb);
+	num_view(b, &y, yb);
+	size = x.len + y.len + 2;
+	buf = malloc(2 * size * sizeof(*buf));
+	if (buf == NULL)
+		err(4);
+	r.d = buf;
+	q.d = buf + size;
+	y.neg ^= op == '-';
+	if ((op == '+' || op == '-') && x.neg == y.neg)
+		mag_add(&r, &x, &y);
+	else if (op == '+' || op == '-')
+	{
+		res = mag_cmp(&x, &y) >= 0 ? &r : &q;
+		mag_sub(res, res == &r ? &x : &y, res == &r ? &y : &x);
+		x.neg = res == &r ? x.neg : y.neg;
+	}
+	else if (op == '*')
+		mag_mul(&r, &x, &y);
+	else
+		mag_divmod(&q, &r, &x, &y);
+	if (op == '*' || op == '/')
+		x.neg = x.neg != y.neg;
+	res = op == '/' ? &q : res;
+	res->neg = x.neg;
+	num_store(a, res);
+	free(buf);
+}
+
+/**
+ * Computes `a = a op b` on values of any size.
+
+ * @param a: The node holding the left operand, receiving the result.
+
+ * @param b: The node holding the right operand, not 0 for '/' and '%'.
+
+ * @param op: '+', '-', '*', '/' or '%'.
+
+ * This is the slow path of the arithmetic opcodes, taken when an operand
+ * is boxed or an int operation overflows. Values that fit in 64 bits are
+ * computed with overflow checks first; only results that do not fit go
+ * through the bignum code.
+ */
+void num_arith(stack_t *a, stack_t *b, int op)
+{
+	long x, y, r = 0;
+	int ok;
+
+	if (num_long(a, &x) == 0 && num_long(b, &y) == 0)
+	{
+		if (op == '+')
+			ok = !__builtin_add_overflow(x, y, &r);
+		else if (op == '-')
+			ok = !__builtin_sub_overflow(x, y, &r);
+		else if (op == '*')
+			ok = !__builtin_mul_overflow(x, y, &r);
+		else
+		{
+			ok = x != LONG_MIN || y != -1;
+			if (ok)
+				r = op == '/' ? x / y : x % y;
+		}
+		if (ok)
+		{
+			num_set_long(a, r);
+			return;
+		}
+	}
+	big_arith(a, b, op);
+}
+
+/**
+ * Compares the values of two nodes.
+
+ * @param a: The first node.
+
+ * @param b: The second node.
+
+ * @return: A negative number, 0 or a positive number when `a` is less than,
+ * equal to or greater than `b`.
+ */
+int num_cmp(stack_t *a, stack_t *b)
+{
+	unsigned int xb[2], yb[2];
+	big_t x, y;
+
+	if (a->tag == TAG_INT && b->tag == TAG_INT)
+		return ((a->n > b->n) - (a->n < b->n));
+	num_view(a, &x, xb);
+	num_view(b, &y, yb);
+	if (x.neg != y.neg)
+		return (x.neg ? -1 : 1);
+	return (x.neg ? mag_cmp(&y, &x) : mag_cmp(&x, &y));
+}
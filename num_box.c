@@ -0,0 +1,105 @@
+#include "monty.h"
+
+num_t *boxes;
+static size_t nboxes, bsize, binit;
+static int bfree = -1;
+
+/**
+ * Takes a box for a value that does not fit in an int.
+
+ * @return: The index of the box. Its fields are left for the caller to set.
+
+ * Freed boxes are reused first. The limbs of a box are kept when it is
+ * freed, so a box reused for a bignum rarely allocates.
+ */
+int box_new(void)
+{
+	num_t *tmp;
+	int i;
+
+	if (bfree != -1)
+	{
+		i = bfree;
+		bfree = boxes[i].next;
+		return (i);
+	}
+	if (nboxes == bsize)
+	{
+		tmp = realloc(boxes, (bsize * 2 + 64) * sizeof(num_t));
+		if (tmp == NULL)
+			err(4);
+		boxes = tmp;
+		bsize = bsize * 2 + 64;
+	}
+	if (nboxes == binit)
+	{
+		boxes[binit].d = NULL;
+		boxes[binit++].cap = 0;
+	}
+	return (nboxes++);
+}
+
+/**
+ * Gives a box back.
+
+ * @param i: The index of the box.
+ */
+void box_free(int i)
+{
+	boxes[i].next = bfree;
+	bfree = i;
+}
+
+/**
+ * Frees every box at once, along with the nodes of the pool.
+
+ * Like pool_reset, the cost does not depend on how many boxes were used.
+ */
+void box_reset(void)
+{
+	nboxes = 0;
+	bfree = -1;
+}
+
+/**
+ * Copies the value of a node into another node.
+
+ * @param dst: The node receiving the value.
+
+ * @param src: The node holding the value.
+
+ * A boxed value gets a box of its own, so the two nodes can be freed or
+ * changed independently.
+ */
+void num_copy(stack_t *dst, stack_t *src)
+{
+	unsigned int buf[2];
+	big_t b;
+
+	if (src->tag == TAG_INT)
+	{
+		num_set_long(dst, src->n);
+		return;
+	}
+	num_view(src, &b, buf);
+	num_store(dst, &b);
+}
+
+/**
+ * Moves the value of a node into another node.
+
+ * @param dst: The node receiving the value; its previous value is dropped.
+
+ * @param src: The node holding the value; it is left holding 0.
+
+ * The box of a boxed value changes hands, nothing is copied.
+ */
+void num_move(stack_t *dst, stack_t *src)
+{
+	if (dst->tag != TAG_INT)
+		box_free(dst->n);
+	dst->n = src->n;
+	dst->tag = src->tag;
+	src->n = 0;
+	src->tag = TAG_INT;
+}
@@ -0,0 +1,162 @@
+#include "monty.h"
+
+/**
+ * Divides a magnitude by a single limb.
+
+ * @param q: Receives |a| / d; room for as many limbs as `a`. It may be `a`.
+
+ * @param a: The dividend.
+
+ * @param d: The divisor, not 0.
+
+ * @return: The remainder.
+ */
+unsigned int mag_div_small(big_t *q, big_t *a, unsigned int d)
+{
+	unsigned long cur = 0;
+	size_t i, len = a->len;
+
+	for (i = len; i > 0; i--)
+	{
+		cur = cur << 32 | a->d[i - 1];
+		q->d[i - 1] = (unsigned int)(cur / d);
+		cur %= d;
+	}
+	q->len = len;
+	while (q->len > 0 && q->d[q->len - 1] == 0)
+		q->len--;
+	return ((unsigned int)cur);
+}
+
+/**
+ * Shifts the limbs of a magnitude left by less than a limb.
+
+ * @param out: Receives the shifted limbs, `len + 1` of them.
+
+ * @param in: The limbs.
+
+ * @param len: The number of limbs.
+
+ * @param s: The shift, from 0 to 31.
+ */
+static void mag_shl(unsigned int *out, unsigned int *in, size_t len, int s)
+{
+	size_t i;
+
+	out[len] = s == 0 ? 0 : in[len - 1] >> (32 - s);
+	for (i = len - 1; i > 0; i--)
+		out[i] = in[i] << s | (s == 0 ? 0 : in[i - 1] >> (32 - s));
+	out[0] = in[0] << s;
+}
+
+/**
+ * Runs the long division of normalized limbs (Knuth, algorithm D).
+
+ * @param q: Receives the `m + 1` quotient limbs.
+
+ * @param un: The dividend, `m + n + 1` limbs; left holding the remainder.
+
+ * @param vn: The divisor, `n` limbs (n >= 2), its top bit set.
+
+ * @param m: The number of limbs of the dividend minus `n`.
+
+ * @param n: The number of limbs of the divisor.
+
+ * Each quotient limb is estimated from the top two limbs of the remainder
+ * and the top limb of the divisor, corrected with the next limb (it is then
+ * at most one too large), and fixed by adding the divisor back when the
+ * subtraction goes negative.
+ */
+static void mag_knuth(unsigned int *q, unsigned int *un, unsigned int *vn,
+		      size_t m, size_t n)
+{
+	unsigned long qhat, rhat, p, b = 1UL << 32;
+	long t, k;
+	size_t i, j;
+
+	for (j = m + 1; j-- > 0;)
+	{
+		qhat = ((unsigned long)un[j + n] << 32 | un[j + n - 1]) /
+			vn[n - 1];
+		rhat = ((unsigned long)un[j + n] << 32 | un[j + n - 1]) -
+			qhat * vn[n - 1];
+		while (qhat >= b || qhat * vn[n - 2] > (rhat << 32 | un[j + n - 2]))
+		{
+			qhat--;
+			rhat += vn[n - 1];
+			if (rhat >= b)
+				break;
+		}
+		for (i = 0, k = 0; i < n; i++)
+		{
+			p = qhat * vn[i];
+			t = (long)un[i + j] - k - (long)(p & 0xffffffffUL);
+			un[i + j] = (unsigned int)t;
+			k = (long)(p >> 32) - (t >> 32);
+		}
+		t = (long)un[j + n] - k;
+		un[j + n] = (unsigned int)t;
+		q[j] = (unsigned int)qhat;
+		if (t >= 0)
+			continue;
+		q[j]--;
+		for (i = 0, p = 0; i < n; i++)
+		{
+			p += (unsigned long)un[i + j] + vn[i];
+			un[i + j] = (unsigned int)p;
+			p >>= 32;
+		}
+		un[j + n] += (unsigned int)p;
+	}
+}
+
+/**
+ * Divides two magnitudes, truncating.
+
+ * @param q: Receives |a| / |b|; room for as many limbs as `a`.
+
+ * @param r: Receives |a| % |b|; room for as many limbs as `a`.
+
+ * @param a: The dividend.
+
+ * @param b: The divisor, not 0.
+ */
+void mag_divmod(big_t *q, big_t *r, big_t *a, big_t *b)
+{
+	unsigned int *un, *vn;
+	size_t i, n = b->len, m;
+	int s;
+
+	if (mag_cmp(a, b) < 0)
+	{
+		q->len = 0;
+		memcpy(r->d, a->d, a->len * sizeof(*a->d));
+		r->len = a->len;
+		return;
+	}
+	if (n == 1)
+	{
+		r->d[0] = mag_div_small(q, a, b->d[0]);
+		r->len = r->d[0] != 0;
+		return;
+	}
+	m = a->len - n;
+	un = malloc((a->len + 1 + n) * sizeof(*un));
+	if (un == NULL)
+		err(4);
+	vn = un + a->len + 1;
+	s = __builtin_clz(b->d[n - 1]);
+	mag_shl(un, a->d, a->len, s);
+	mag_shl(vn, b->d, n - 1, s);
+	vn[n - 1] = b->d[n - 1] << s | (s == 0 ? 0 : b->d[n - 2] >> (32 - s));
+	mag_knuth(q->d, un, vn, m, n);
+	for (i = 0; i < n; i++)
+		r->d[i] = un[i] >> s | (s == 0 ? 0 : un[i + 1] << (32 - s));
+	q->len = m + 1;
+	while (q->len > 0 && q->d[q->len - 1] == 0)
+		q->len--;
+	r->len = n;
+	while (r->len > 0 && r->d[r->len - 1] == 0)
+		r->len--;
+	free(un);
+}
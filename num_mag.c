@@ -0,0 +1,113 @@
+#include "monty.h"
+
+/**
+ * Compares two magnitudes, ignoring their signs.
+
+ * @param a: The first magnitude.
+
+ * @param b: The second magnitude.
+
+ * @return: A negative number, 0 or a positive number when |a| is less than,
+ * equal to or greater than |b|.
+ */
+int mag_cmp(big_t *a, big_t *b)
+{
+	size_t i;
+
+	if (a->len != b->len)
+		return (a->len < b->len ? -1 : 1);
+	for (i = a->len; i > 0; i--)
+	{
+		if (a->d[i - 1] != b->d[i - 1])
+			return (a->d[i - 1] < b->d[i - 1] ? -1 : 1);
+	}
+	return (0);
+}
+
+/**
+ * Adds two magnitudes.
+
+ * @param r: Receives |a| + |b|; room for one limb more than the longest.
+
+ * @param a: The first magnitude.
+
+ * @param b: The second magnitude.
+ */
+void mag_add(big_t *r, big_t *a, big_t *b)
+{
+	unsigned long c = 0;
+	big_t *t;
+	size_t i;
+
+	if (a->len < b->len)
+	{
+		t = a;
+		a = b;
+		b = t;
+	}
+	for (i = 0; i < a->len; i++)
+	{
+		c += (unsigned long)a->d[i] + (i < b->len ? b->d[i] : 0);
+		r->d[i] = (unsigned int)c;
+		c >>= 32;
+	}
+	r->d[i] = (unsigned int)c;
+	r->len = i + (c != 0);
+}
+
+/**
+ * Subtracts a magnitude from a larger or equal one.
+
+ * @param r: Receives |a| - |b|; room for as many limbs as `a`.
+
+ * @param a: The larger magnitude.
+
+ * @param b: The smaller magnitude.
+ */
+void mag_sub(big_t *r, big_t *a, big_t *b)
+{
+	unsigned long t, borrow = 0;
+	size_t i;
+
+	for (i = 0; i < a->len; i++)
+	{
+		t = (unsigned long)a->d[i] - (i < b->len ? b->d[i] : 0) -
+			borrow;
+		r->d[i] = (unsigned int)t;
+		borrow = t >> 63;
+	}
+	r->len = a->len;
+	while (r->len > 0 && r->d[r->len - 1] == 0)
+		r->len--;
+}
+
+/**
+ * Multiplies two magnitudes.
+
+ * @param r: Receives |a| * |b|; room for the limbs of `a` and `b` together.
+
+ * @param a: The first magnitude.
+
+ * @param b: The second magnitude.
+ */
+void mag_mul(big_t *r, big_t *a, big_t *b)
+{
+	unsigned long c;
+	size_t i, j;
+
+	memset(r->d, 0, (a->len + b->len) * sizeof(*r->d));
+	for (i = 0; i < a->len; i++)
+	{
+		c = 0;
+		for (j = 0; j < b->len; j++)
+		{
+			c += (unsigned long)a->d[i] * b->d[j] + r->d[i + j];
+			r->d[i + j] = (unsigned int)c;
+			c >>= 32;
+		}
+		r->d[i + j] = (unsigned int)c;
+	}
+	r->len = a->len + b->len;
+	while (r->len > 0 && r->d[r->len - 1] == 0)
+		r->len--;
+}
@@ -0,0 +1,120 @@
+#include "monty.h"
+#include <limits.h>
+
+/**
+ * Gives the magnitude and sign of the value of a node.
+
+ * @param node: The node.
+
+ * @param b: Receives the value.
+
+ * @param buf: Two limbs to hold the magnitude of an int or 64-bit value.
+
+ * The limbs of a bignum are those of its box; they stay valid until the
+ * value of the node changes.
+ */
+void num_view(stack_t *node, big_t *b, unsigned int *buf)
+{
+	unsigned long mag;
+	long v;
+
+	if (node->tag == TAG_BIG)
+	{
+		b->d = boxes[node->n].d;
+		b->len = boxes[node->n].len;
+		b->neg = boxes[node->n].neg;
+		return;
+	}
+	v = node->tag == TAG_INT ? node->n : boxes[node->n].v;
+	mag = v < 0 ? 0UL - (unsigned long)v : (unsigned long)v;
+	buf[0] = (unsigned int)mag;
+	buf[1] = (unsigned int)(mag >> 32);
+	b->d = buf;
+	b->len = buf[1] != 0 ? 2 : buf[0] != 0;
+	b->neg = v < 0;
+}
+
+/**
+ * Sets the value of a node from a magnitude and a sign.
+
+ * @param node: The node; a box it already has is reused.
+
+ * @param b: The value. Its leading zero limbs are dropped from `len`.
+
+ * The value is stored in its smallest form (see num_t).
+ */
+void num_store(stack_t *node, big_t *b)
+{
+	unsigned long mag;
+	unsigned int *d;
+	num_t *box;
+
+	while (b->len > 0 && b->d[b->len - 1] == 0)
+		b->len--;
+	if (b->len <= 2)
+	{
+		mag = b->len == 0 ? 0 : b->d[0];
+		mag |= b->len == 2 ? (unsigned long)b->d[1] << 32 : 0;
+		if (mag <= (unsigned long)LONG_MAX + b->neg)
+		{
+			num_set_long(node, b->neg ? (long)(0UL - mag)
+				   : (long)mag);
+			return;
+		}
+	}
+	if (node->tag == TAG_INT)
+		node->n = box_new();
+	node->tag = TAG_BIG;
+	box = &boxes[node->n];
+	if (box->cap < b->len)
+	{
+		d = realloc(box->d, b->len * 2 * sizeof(*d));
+		if (d == NULL)
+			err(4);
+		box->d = d;
+		box->cap = b->len * 2;
+	}
+	memcpy(box->d, b->d, b->len * sizeof(*b->d));
+	box->len = b->len;
+	box->neg = b->neg;
+}
+
+/**
+ * Sets the value of a node from a 64-bit integer.
+
+ * @param node: The node; a box it already has is reused or freed.
+
+ * @param v: The value.
+ */
+void num_set_long(stack_t *node, long v)
+{
+	if (v >= INT_MIN && v <= INT_MAX)
+	{
+		if (node->tag != TAG_INT)
+			box_free(node->n);
+		node->tag = TAG_INT;
+		node->n = (int)v;
+		return;
+	}
+	if (node->tag == TAG_INT)
+		node->n = box_new();
+	node->tag = TAG_LONG;
+	boxes[node->n].v = v;
+}
+
+/**
+ * Gives the value of a node as a 64-bit integer.
+
+ * @param node: The node.
+
+ * @param v: Receives the value.
+
+ * @return: 0 on success, 1 if the value is a bignum.
+ */
+int num_long(stack_t *node, long *v)
+{
+	if (node->tag == TAG_BIG)
+		return (1);
+	*v = node->tag == TAG_INT ? node->n : boxes[node->n].v;
+	return (0);
+}
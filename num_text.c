@@ -0,0 +1,152 @@
+#include "monty.h"
+#include <limits.h>
+
+/**
+ * Prints the value of a node in decimal, followed by a newline.
+
+ * @param fp: The stream to print to.
+
+ * @param node: The node.
+
+ * A bignum is cut into groups of 9 digits by dividing it by 10^9 over and
+ * over, then printed from the most significant group.
+ */
+void num_print(FILE *fp, stack_t *node)
+{
+	unsigned int *groups;
+	size_t k = 0;
+	big_t q;
+
+	if (node->tag == TAG_INT)
+	{
+		fprintf(fp, "%d\n", node->n);
+		return;
+	}
+	if (node->tag == TAG_LONG)
+	{
+		fprintf(fp, "%ld\n", boxes[node->n].v);
+		return;
+	}
+	q.len = boxes[node->n].len;
+	groups = malloc((3 * q.len + 1) * sizeof(*groups));
+	if (groups == NULL)
+		err(4);
+	q.d = groups + 2 * q.len + 1;
+	memcpy(q.d, boxes[node->n].d, q.len * sizeof(*q.d));
+	while (q.len > 0)
+		groups[k++] = mag_div_small(&q, &q, 1000000000);
+	fprintf(fp, "%s%u", boxes[node->n].neg ? "-" : "", groups[--k]);
+	while (k > 0)
+		fprintf(fp, "%09u", groups[--k]);
+	fputc('\n', fp);
+	free(groups);
+}
+
+/**
+ * Sets the value of a node from a decimal integer of any length.
+
+ * @param node: The node.
+
+ * @param s: An optional '-' followed by digits, as checked by parse_push.
+
+ * The digits are taken 9 at a time: each group multiplies the value read
+ * so far by 10^9 (or less for the first group) and is added to it.
+ */
+void num_parse(stack_t *node, char *s)
+{
+	unsigned long c, mul;
+	unsigned int group;
+	size_t len, i, k;
+	big_t r;
+
+	r.neg = *s == '-';
+	s += r.neg;
+	len = strlen(s);
+	r.d = malloc((len / 9 + 2) * sizeof(*r.d));
+	if (r.d == NULL)
+		err(4);
+	for (r.len = 0, k = (len - 1) % 9 + 1; len > 0; s += k, len -= k, k = 9)
+	{
+		for (i = 0, group = 0, mul = 1; i < k; i++, mul *= 10)
+			group = group * 10 + (s[i] - '0');
+		for (i = 0, c = group; i < r.len; i++)
+		{
+			c += r.d[i] * mul;
+			r.d[i] = (unsigned int)c;
+			c >>= 32;
+		}
+		if (c != 0)
+			r.d[r.len++] = (unsigned int)c;
+	}
+	num_store(node, &r);
+	free(r.d);
+}
+
+/**
+ * Packs the value of a node into ints, for snapshots.
+
+ * @param node: The node.
+
+ * @param out: Where to write the ints, or NULL to only count them.
+
+ * @return: The number of ints.
+
+ * An int other than INT_MIN is packed as itself. Any other value is
+ * INT_MIN, then its number of limbs (negated for a negative value), then
+ * its limbs.
+ */
+size_t num_pack(stack_t *node, int *out)
+{
+	unsigned int buf[2];
+	big_t b;
+
+	if (node->tag == TAG_INT && node->n != INT_MIN)
+	{
+		if (out != NULL)
+			*out = node->n;
+		return (1);
+	}
+	num_view(node, &b, buf);
+	if (out != NULL)
+	{
+		out[0] = INT_MIN;
+		out[1] = b.neg ? -(int)b.len : (int)b.len;
+		memcpy(out + 2, b.d, b.len * sizeof(*b.d));
+	}
+	return (b.len + 2);
+}
+
+/**
+ * Unpacks a value packed by num_pack into a node.
+
+ * @param node: The node, or NULL to only check the packed value.
+
+ * @param in: The packed value.
+
+ * @param avail: The number of ints available at `in`.
+
+ * @return: The number of ints of the value, 0 if it does not fit in `avail`.
+ */
+size_t num_unpack(stack_t *node, int *in, size_t avail)
+{
+	big_t b;
+
+	if (avail == 0)
+		return (0);
+	if (in[0] != INT_MIN)
+	{
+		if (node != NULL)
+			num_set_long(node, in[0]);
+		return (1);
+	}
+	if (avail < 2 || in[1] == INT_MIN)
+		return (0);
+	b.len = in[1] < 0 ? (size_t)-in[1] : (size_t)in[1];
+	if (b.len > avail - 2)
+		return (0);
+	b.d = (unsigned int *)(in + 2);
+	b.neg = in[1] < 0;
+	if (node != NULL)
+		num_store(node, &b);
+	return (b.len + 2);
+}
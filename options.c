@@ -0,0 +1,149 @@
+#include "monty.h"
+
+#define WITH_SPILL 1
+#define WITH_CACHE 2
+#define WITH_IR 4
+#define WITH_ALL (WITH_SPILL | WITH_CACHE | WITH_IR)
+
+/**
+ * Rejects the options that cannot be combined.
+
+ * @param opts: The options.
+
+ * The spill files hold the stack and the instructions of one script run
+ * from start to end: the options reading the whole program again (or
+ * running several at once) would quietly go over the budget. `--cache`
+ * only stores the output of a plain run, and `--ir` only lowers it, so
+ * both would be ignored by the other modes. Each mode lists the options it
+ * cannot be used with.
+ */
+static void check_modes(options_t *opts)
+{
+	static const struct
+	{
+		char *name;
+		size_t offset;
+		int with;
+	} modes[] = {
+		{"--opt", offsetof(options_t, opt), WITH_SPILL},
+		{"--ir", offsetof(options_t, ir), WITH_SPILL},
+		{"--lanes", offsetof(options_t, lanes), WITH_ALL},
+		{"--serve", offsetof(options_t, serve), WITH_ALL},
+		{"--sched", offsetof(options_t, sched), WITH_ALL},
+		{"--checkpoint-every", offsetof(options_t, checkpoint_every),
+		 WITH_ALL},
+		{"--resume", offsetof(options_t, resume), WITH_ALL},
+		{"--incremental", offsetof(options_t, incremental), WITH_ALL},
+		{"--perf-counters", offsetof(options_t, perf_counters),
+		 WITH_ALL},
+		{"--bf", offsetof(options_t, bf), WITH_CACHE | WITH_IR},
+		{NULL, 0, 0}
+	};
+	char *with[] = {"--spill", "--cache", "--ir"};
+	int set[3], i, k;
+
+	set[0] = opts->spill != NULL;
+	set[1] = opts->cache != NULL;
+	set[2] = opts->ir != NULL;
+	for (k = 0; k < 3; k++)
+	{
+		for (i = 0; set[k] && modes[i].name != NULL; i++)
+		{
+			if ((modes[i].with & (1 << k)) &&
+			    *(char **)((char *)opts + modes[i].offset) != NULL)
+				err(24, with[k], modes[i].name);
+		}
+	}
+}
+
+/**
+ * Parses the command line into options.
+
+ * @param argc: The number of command-line arguments.
+
+ * @param argv: The command-line arguments.
+
+ * @param opts: The options to fill.
+
+ * Options come before the file name. Anything that is not a known option,
+ * a missing option argument or a missing file name is a usage error; only
+ * `--serve` runs without a file.
+ */
+void parse_opts(int argc, char **argv, options_t *opts)
+{
+	static const struct
+	{
+		char *name;
+		int has_arg;
+		size_t offset;
+	} opt_list[] = {
+		{"--lanes", 1, offsetof(options_t, lanes)},
+		{"--cache", 1, offsetof(options_t, cache)},
+		{"--cache-size", 1, offsetof(options_t, cache_size)},
+		{"--spill", 1, offsetof(options_t, spill)},
+		{"--mem-budget", 1, offsetof(options_t, mem_budget)},
+		{"--serve", 1, offsetof(options_t, serve)},
+		{"--workers", 1, offsetof(options_t, workers)},
+		{"--budget", 1, offsetof(options_t, budget)},
+		{"--sched", 0, offsetof(options_t, sched)},
+		{"--quantum", 1, offsetof(options_t, quantum)},
+		{"--stats", 0, offsetof(options_t, stats)},
+		{"--opt", 0, offsetof(options_t, opt)},
+		{"--checkpoint-every", 1, offsetof(options_t, checkpoint_every)},
+		{"--checkpoint", 1, offsetof(options_t, checkpoint)},
+		{"--resume", 1, offsetof(options_t, resume)},
+		{"--incremental", 1, offsetof(options_t, incremental)},
+		{"--snapshot-every", 1, offsetof(options_t, snapshot_every)},
+		{"--bf", 0, offsetof(options_t, bf)},
+		{"--tape-size", 1, offsetof(options_t, tape_size)},
+		{"--ir", 0, offsetof(options_t, ir)},
+		{"--perf-counters", 0, offsetof(options_t, perf_counters)},
+		{NULL, 0, 0}
+	};
+	int i, j;
+
+	memset(opts, 0, sizeof(*opts));
+	for (i = 1; i < argc && strncmp(argv[i], "--", 2) == 0; i++)
+	{
+		for (j = 0; opt_list[j].name != NULL; j++)
+		{
+			if (strcmp(argv[i], opt_list[j].name) == 0)
+				break;
+		}
+		if (opt_list[j].name == NULL || i + opt_list[j].has_arg >= argc)
+			err(1);
+		*(char **)((char *)opts + opt_list[j].offset) =
+			opt_list[j].has_arg ? argv[++i] : "";
+	}
+	if (i == argc - 1)
+		opts->file = argv[i];
+	else if (i != argc || opts->serve == NULL)
+		err(1);
+	check_modes(opts);
+}
+
+/**
+ * Converts a size option to a number of bytes.
+
+ * @param str: The option value: digits with an optional K, M or G suffix.
+
+ * @return: The size in bytes.
+ */
+unsigned long parse_size(char *str)
+{
+	unsigned long size;
+	char *end;
+
+	size = strtoul(str, &end, 10);
+	if (end == str)
+		err(1);
+	if (*end == 'K' || *end == 'k')
+		size <<= 10;
+	else if (*end == 'M' || *end == 'm')
+		size <<= 20;
+	else if (*end == 'G' || *end == 'g')
+		size <<= 30;
+	else if (*end != '\0')
+		err(1);
+	return (size);
+}
@@ -0,0 +1,194 @@
+#include "monty.h"
+#include <pthread.h>
+#include <sys/uio.h>
+
+/**
+ * Formats a range of nodes like `printf("%d\n")` would, one value per line.
+
+ * @param node: The first node of the range.
+
+ * @param count: The number of nodes in the range.
+
+ * @param buf: The buffer, at least 12 bytes per node.
+
+ * @return: The number of bytes written to `buf`.
+ */
+static size_t pall_format(stack_t *node, size_t count, char *buf)
+{
+	char digits[12], *out = buf, *d;
+	unsigned int v;
+
+	for (; count > 0; count--, node = node->next)
+	{
+		v = node->n < 0 ? -(unsigned int)node->n : (unsigned int)node->n;
+		d = digits + sizeof(digits);
+		*--d = '\n';
+		do {
+			*--d = '0' + v % 10;
+			v /= 10;
+		} while (v != 0);
+		if (node->n < 0)
+			*--d = '-';
+		memcpy(out, d, digits + sizeof(digits) - d);
+		out += digits + sizeof(digits) - d;
+	}
+	return (out - buf);
+}
+
+/**
+ * Formats ranges of a `pall` job until none is left in the current round.
+
+ * @param arg: The job.
+
+ * @return: NULL.
+
+ * Ranges are taken one at a time from a shared counter, so threads that
+ * finish early take more of them.
+ */
+static void *pall_worker(void *arg)
+{
+	pall_job_t *job = arg;
+	size_t i;
+
+	while ((i = __sync_fetch_and_add(&job->next, 1)) < job->end)
+		job->lens[i % job->slots] = pall_format(job->starts[i],
+			i == job->nranges - 1 ? job->tail : PALL_CHUNK,
+			job->bufs[i % job->slots]);
+	return (NULL);
+}
+
+/**
+ * Writes buffers to a file descriptor in order, with as few writev as possible.
+
+ * @param fd: The descriptor.
+
+ * @param iov: The buffers; modified when a write is partial.
+
+ * @param n: The number of buffers.
+ */
+static void pall_write(int fd, struct iovec *iov, size_t n)
+{
+	ssize_t done;
+
+	while (n > 0)
+	{
+		done = writev(fd, iov, n > 1024 ? 1024 : n);
+		if (done <= 0)
+			return;
+		for (; n > 0 && (size_t)done >= iov->iov_len; iov++, n--)
+			done -= iov->iov_len;
+		if (n > 0)
+		{
+			iov->iov_base = (char *)iov->iov_base + done;
+			iov->iov_len -= done;
+		}
+	}
+}
+
+/**
+ * Formats the ranges of a job in rounds and writes each round out.
+
+ * @param job: The job, with its ranges found.
+
+ * @param fd: The descriptor the output goes to.
+
+ * Each round formats `slots` ranges on all the threads (this one included)
+ * and writes them with writev, so the output comes out in order and the
+ * memory used does not grow with the stack.
+ */
+static void pall_rounds(pall_job_t *job, int fd)
+{
+	pthread_t tid[64];
+	struct iovec iov[256];
+	size_t base, i, started;
+	long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	nthreads = nthreads > 64 ? 64 : nthreads;
+	for (base = 0; base < job->nranges; base = job->end)
+	{
+		job->next = base;
+		job->end = base + job->slots < job->nranges ? base + job->slots
+			: job->nranges;
+		for (started = 0; (long)started + 1 < nthreads; started++)
+		{
+			if (pthread_create(&tid[started], NULL, pall_worker, job) != 0)
+				break;
+		}
+		pall_worker(job);
+		for (i = 0; i < started; i++)
+			pthread_join(tid[i], NULL);
+		for (i = base; i < job->end; i++)
+		{
+			iov[i - base].iov_base = job->bufs[i % job->slots];
+			iov[i - base].iov_len = job->lens[i % job->slots];
+		}
+		pall_write(fd, iov, job->end - base);
+	}
+}
+
+/**
+ * Prints a large stack with several threads, one value per line.
+
+ * @param top: The top of the stack.
+
+ * @return: 0 if the stack was printed, -1 if it should be printed serially.
+
+ * The stack is walked once to find where every range of PALL_CHUNK nodes
+ * starts; the ranges are then formatted in parallel (see pall_rounds).
+ * Stacks of less than PALL_MIN nodes or holding boxed values, output that
+ * is not a file descriptor (memory streams) and spilled stacks, whose pages
+ * are tracked by a single thread, stay on the serial path. The bytes are
+ * the same either way.
+ */
+int pall_parallel(stack_t *top)
+{
+	pall_job_t job;
+	size_t n = 0, size = 0, i;
+	stack_t **starts;
+	int fd = fileno(out_stream);
+
+	for (starts = &top; *starts != NULL && n < PALL_MIN; n++)
+		starts = &(*starts)->next;
+	if (n < PALL_MIN || fd == -1 || pool.spill)
+		return (-1);
+	memset(&job, 0, sizeof(job));
+	for (n = 0; top != NULL; top = top->next, n++)
+	{
+		if (top->tag != TAG_INT)
+		{
+			free(job.starts);
+			return (-1);
+		}
+		if (n % PALL_CHUNK != 0)
+			continue;
+		if (job.nranges == size)
+		{
+			size = size * 2 + 64;
+			starts = realloc(job.starts, size * sizeof(*starts));
+			if (starts == NULL)
+				err(4);
+			job.starts = starts;
+		}
+		job.starts[job.nranges++] = top;
+	}
+	job.tail = n - (job.nranges - 1) * PALL_CHUNK;
+	job.slots = job.nranges < 256 ? job.nranges : 256;
+	job.bufs = malloc(job.slots * sizeof(char *));
+	job.lens = malloc(job.slots * sizeof(size_t));
+	if (job.bufs == NULL || job.lens == NULL)
+		err(4);
+	for (i = 0; i < job.slots; i++)
+	{
+		job.bufs[i] = malloc(PALL_CHUNK * 12);
+		if (job.bufs[i] == NULL)
+			err(4);
+	}
+	fflush(out_stream);
+	pall_rounds(&job, fd);
+	for (i = 0; i < job.slots; i++)
+		free(job.bufs[i]);
+	free(job.bufs);
+	free(job.lens);
+	free(job.starts);
+	return (0);
+}
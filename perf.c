@@ -0,0 +1,135 @@
+#include "monty.h"
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+/**
+ * Opens the counters of a `--perf-counters` run as one group.
+
+ * @param p: Receives the counters; `fd` is -1 when none could be opened.
+
+ * Every counter is tried on its own, so a machine without one of them (a
+ * virtual machine often has no hardware counter at all) still counts the
+ * others. Only user space is counted. The group starts disabled and
+ * counting starts here, once all the counters are open.
+ */
+void perf_open(perf_t *p)
+{
+	static const struct
+	{
+		char *name;
+		unsigned int type;
+		unsigned long config;
+	} events[PERF_EVENTS] = {
+		{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+		{"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+		{"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+		{"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+		{"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}
+	};
+	struct perf_event_attr attr;
+	int i;
+
+	p->fd = -1;
+	for (i = 0; i < PERF_EVENTS; i++)
+	{
+		p->names[i] = events[i].name;
+		p->slot[i] = -1;
+		p->errs[i] = 0;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = events[i].type;
+		attr.config = events[i].config;
+		attr.disabled = p->fd == -1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP |
+			PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		p->fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, p->fd, 0);
+		if (p->fds[i] == -1)
+		{
+			p->errs[i] = errno;
+			continue;
+		}
+		p->slot[i] = p->nopen++;
+		if (p->fd == -1)
+			p->fd = p->fds[i];
+	}
+	if (p->fd != -1)
+		ioctl(p->fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+/**
+ * Reads all the counters at once.
+
+ * @param p: The counters.
+
+ * @param v: Receives the value of each counter, 0 for an absent one.
+
+ * @return: 0 on success, -1 when there are no counters or the read failed.
+ */
+int perf_read(perf_t *p, unsigned long *v)
+{
+	unsigned long buf[3 + PERF_EVENTS];
+	int i;
+
+	if (p->fd == -1 ||
+	    read(p->fd, buf, sizeof(buf)) < (ssize_t)((3 + p->nopen) *
+						      sizeof(*buf)))
+		return (-1);
+	p->enabled = buf[1];
+	p->running = buf[2];
+	for (i = 0; i < PERF_EVENTS; i++)
+		v[i] = p->slot[i] == -1 ? 0 : buf[3 + p->slot[i]];
+	return (0);
+}
+
+/**
+ * Measures what the counters count between two reads with nothing between
+ * them.
+
+ * @param p: The counters; receives the smallest count of each in `base`.
+
+ * A sample is taken between two reads, so it also counts the end of the
+ * first read and the start of the second; that part is taken off.
+ */
+void perf_calibrate(perf_t *p)
+{
+	unsigned long a[PERF_EVENTS], b[PERF_EVENTS];
+	int i, k;
+
+	for (i = 0; i < PERF_EVENTS; i++)
+		p->base[i] = (unsigned long)-1;
+	for (k = 0; k < 32; k++)
+	{
+		if (perf_read(p, a) != 0 || perf_read(p, b) != 0)
+			break;
+		for (i = 0; i < PERF_EVENTS; i++)
+		{
+			if (b[i] - a[i] < p->base[i])
+				p->base[i] = b[i] - a[i];
+		}
+	}
+	for (i = 0; i < PERF_EVENTS; i++)
+		p->base[i] = p->base[i] == (unsigned long)-1 ? 0 : p->base[i];
+}
+
+/**
+ * Stops and closes the counters.
+
+ * @param p: The counters.
+ */
+void perf_close(perf_t *p)
+{
+	int i;
+
+	if (p->fd != -1)
+		ioctl(p->fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	for (i = 0; i < PERF_EVENTS; i++)
+	{
+		if (p->fds[i] != -1)
+			close(p->fds[i]);
+	}
+	p->fd = -1;
+}
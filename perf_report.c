@@ -0,0 +1,150 @@
+#include "monty.h"
+
+/**
+ * Finds the counts of the opcode of an instruction.
+
+ * @param p: The counters.
+
+ * @param c: The instruction.
+
+ * @return: The counts of its opcode, added when it is new. Past PERF_OPS
+ * opcodes, the last entry holds all the others.
+
+ * Opcodes are mostly the same strings of the opcode table, so the last
+ * entry and a comparison of pointers find nearly all of them.
+ */
+perf_op_t *perf_entry(perf_t *p, code_t *c)
+{
+	char *name = c->op;
+	size_t i;
+
+	if (c->f == push_big_stack || c->f == push_big_queue)
+		name = "push";
+	if (p->nops != 0 && p->ops[p->last].name == name)
+		return (&p->ops[p->last]);
+	for (i = 0; i < p->nops; i++)
+	{
+		if (p->ops[i].name == name)
+			break;
+	}
+	for (i = i < p->nops ? i : 0; i < p->nops; i++)
+	{
+		if (strcmp(p->ops[i].name, name) == 0)
+			break;
+	}
+	if (i == p->nops && p->nops < PERF_OPS)
+		p->ops[p->nops++].name = name;
+	p->last = i < p->nops ? i : p->nops - 1;
+	return (&p->ops[p->last]);
+}
+
+/**
+ * Compares two opcodes for qsort: the most expensive first.
+
+ * @param a: The first opcode.
+
+ * @param b: The second opcode.
+
+ * @return: A negative number when `a` comes first, positive after, else 0.
+
+ * The cost of an opcode is the mean of the first counter over its samples
+ * times its number of runs; opcodes without samples come by runs.
+ */
+static int op_cmp(const void *a, const void *b)
+{
+	const perf_op_t *x = a, *y = b;
+	double cx, cy;
+
+	cx = x->samples == 0 ? 0 : (double)x->sum[0] / x->samples * x->count;
+	cy = y->samples == 0 ? 0 : (double)y->sum[0] / y->samples * y->count;
+	if (cx != cy)
+		return (cx < cy ? 1 : -1);
+	if (x->count != y->count)
+		return (x->count < y->count ? 1 : -1);
+	return (0);
+}
+
+/**
+ * Prints the counters over the whole run.
+
+ * @param p: The counters.
+
+ * @return: The first counter open, the one opcodes are ranked by, or -1.
+
+ * When the kernel multiplexed the counters, the totals are scaled to the
+ * whole run and the share of time they counted is printed.
+ */
+static int perf_totals(perf_t *p)
+{
+	double scale = 1;
+	int i, first = -1;
+
+	if (p->running != 0 && p->running < p->enabled)
+		scale = (double)p->enabled / p->running;
+	for (i = 0; i < PERF_EVENTS; i++)
+	{
+		if (p->slot[i] == -1)
+		{
+			fprintf(err_stream, "perf: %s: not available (%s)\n",
+				p->names[i], strerror(p->errs[i]));
+			continue;
+		}
+		first = first == -1 ? i : first;
+		fprintf(err_stream, "perf: %-13s %15.0f\n", p->names[i],
+			p->total[i] * scale);
+	}
+	if (scale != 1)
+		fprintf(err_stream, "perf: counting %.1f%% of the time\n",
+			100 / scale);
+	return (first);
+}
+
+/**
+ * Prints the report of a `--perf-counters` run on stderr.
+
+ * @param p: The counters.
+
+ * @param prog: The program that ran.
+
+ * @param done: The number of instructions that ran.
+
+ * Every opcode gets its exact number of runs and, for each counter open,
+ * its mean over the sampled runs; the last column is the share of the first
+ * counter spent in the opcode, estimated from that mean. Without counters,
+ * only the runs are printed.
+ */
+void perf_report(perf_t *p, program_t *prog, size_t done)
+{
+	perf_op_t *op;
+	double cost = 0;
+	size_t i;
+	int j, first = perf_totals(p);
+
+	for (i = 0; i < done && i < prog->len; i++)
+		perf_entry(p, &prog->code[i])->count++;
+	qsort(p->ops, p->nops, sizeof(*p->ops), op_cmp);
+	for (i = 0; first != -1 && i < p->nops; i++)
+		if (p->ops[i].samples != 0)
+			cost += (double)p->ops[i].sum[first] / p->ops[i].samples *
+				p->ops[i].count;
+	fprintf(err_stream, "perf: %-10s %12s %9s", "opcode", "runs", "samples");
+	for (j = 0; j < PERF_EVENTS; j++)
+		if (p->slot[j] != -1)
+			fprintf(err_stream, " %13.13s", p->names[j]);
+	fprintf(err_stream, first == -1 ? "\n" : " %6s\n", "share");
+	for (op = p->ops; op < p->ops + p->nops; op++)
+	{
+		fprintf(err_stream, "perf: %-10.10s %12lu %9lu", op->name,
+			op->count, op->samples);
+		for (j = 0; j < PERF_EVENTS; j++)
+			if (p->slot[j] != -1)
+				fprintf(err_stream, " %13.1f", op->samples == 0 ? 0
+					: (double)op->sum[j] / op->samples);
+		if (first != -1)
+			fprintf(err_stream, " %5.1f%%\n", cost == 0 || op->samples == 0
+				? 0 : op->sum[first] / (double)op->samples *
+				op->count * 100 / cost);
+		else
+			fputc('\n', err_stream);
+	}
+}
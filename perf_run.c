@@ -0,0 +1,128 @@
+#include "monty.h"
+
+/**
+ * Draws the number of instructions until the next sample.
+
+ * @param p: The counters, holding the state of the generator.
+
+ * @return: A gap from 1 to 2 * PERF_PERIOD - 1, PERF_PERIOD on average.
+
+ * The gaps are random (xorshift) so that a script repeating a pattern of
+ * instructions is not always sampled at the same place in the pattern.
+ */
+static size_t perf_gap(perf_t *p)
+{
+	p->seed ^= p->seed << 13;
+	p->seed ^= p->seed >> 7;
+	p->seed ^= p->seed << 17;
+	return (1 + p->seed % (2 * PERF_PERIOD - 1));
+}
+
+/**
+ * Runs the instruction at `pc` between two reads of the counters.
+
+ * @param p: The counters.
+
+ * The opcode is looked up before the first read, so the sample only holds
+ * the dispatch and the handler.
+ */
+static void perf_sample(perf_t *p)
+{
+	unsigned long before[PERF_EVENTS], after[PERF_EVENTS], d;
+	perf_op_t *op = perf_entry(p, pc);
+	int i;
+
+	if (perf_read(p, before) != 0)
+	{
+		pc->f(&head, pc->ln);
+		return;
+	}
+	pc->f(&head, pc->ln);
+	if (perf_read(p, after) != 0)
+		return;
+	op->samples++;
+	for (i = 0; i < PERF_EVENTS; i++)
+	{
+		d = after[i] - before[i];
+		op->sum[i] += d > p->base[i] ? d - p->base[i] : 0;
+	}
+}
+
+/**
+ * Runs a loaded program, sampling the counters at dispatch boundaries.
+
+ * @param prog: The program.
+
+ * @param p: The counters. Without any, the program just runs.
+
+ * Every instruction runs through the same loop as run_steps; one in about
+ * PERF_PERIOD runs between two reads of the counters instead.
+ */
+static void perf_loop(program_t *prog, perf_t *p)
+{
+	code_t *end = prog->code + prog->len, *next;
+
+	next = prog->code + perf_gap(p) - 1;
+	for (pc = prog->code; pc < end; pc++)
+	{
+		if (pc != next || p->fd == -1)
+		{
+			pc->f(&head, pc->ln);
+			continue;
+		}
+		perf_sample(p);
+		next += perf_gap(p);
+	}
+}
+
+/**
+ * Runs a program with hardware counters (`--perf-counters`).
+
+ * @param opts: The options.
+
+ * @return: EXIT_SUCCESS, or EXIT_FAILURE when the program failed.
+
+ * The counters are read at the start and the end of the run for the
+ * totals, and around sampled instructions for the counts of each opcode.
+ * Errors come back here through `fail_jmp`, so a failing program is still
+ * reported up to the instruction that failed. The report is printed on
+ * stderr, after the error if there is one.
+ */
+int run_perf(options_t *opts)
+{
+	static program_t prog;
+	static perf_t perf;
+	volatile int status = EXIT_SUCCESS;
+	jmp_buf env;
+	FILE *fd;
+	int i;
+
+	fd = fopen(opts->file, "r");
+	if (fd == NULL)
+		err(2, opts->file);
+	load_program(&prog, fd);
+	fclose(fd);
+	memset(&perf, 0, sizeof(perf));
+	perf.seed = 88172645463325252UL;
+	perf_open(&perf);
+	perf_calibrate(&perf);
+	perf_read(&perf, perf.start);
+	fail_jmp = &env;
+	if (setjmp(env) == 0)
+		perf_loop(&prog, &perf);
+	else
+		status = EXIT_FAILURE;
+	fail_jmp = NULL;
+	if (perf_read(&perf, perf.total) == 0)
+	{
+		for (i = 0; i < PERF_EVENTS; i++)
+			perf.total[i] -= perf.start[i];
+	}
+	perf_close(&perf);
+	fflush(out_stream);
+	perf_report(&perf, &prog, pc - prog.code + (status != EXIT_SUCCESS));
+	if (status == EXIT_SUCCESS)
+		free_nodes();
+	free_program(&prog);
+	return (status);
+}
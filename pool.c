@@ -0,0 +1,99 @@
+#include "monty.h"
+#include <sys/mman.h>
+
+pool_t pool = {NULL, 0, 0, 0, 0, NULL, 0, -1, 0, NULL, 0, 0, -1, NULL, 0};
+
+/**
+ * Maps one more segment at the end of the pool.
+
+ * Anonymous segments are plain memory. Spill segments extend the spill file
+ * and are mapped shared, with a sequential access hint since the stack is
+ * mostly walked from one end to the other.
+ */
+static void pool_grow(void)
+{
+	char **segs;
+	char *seg;
+
+	if (pool.nsegs == pool.ssize)
+	{
+		pool.ssize = pool.ssize == 0 ? 16 : pool.ssize * 2;
+		segs = realloc(pool.segs, pool.ssize * sizeof(char *));
+		pool.tick = realloc(pool.tick, pool.ssize * sizeof(unsigned long));
+		if (segs == NULL || pool.tick == NULL)
+			err(4);
+		pool.segs = segs;
+	}
+	if (!pool.spill)
+		seg = mmap(NULL, POOL_SEG, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	else if (ftruncate(pool.fd, (pool.nsegs + 1) * POOL_SEG) == -1)
+		seg = MAP_FAILED;
+	else
+		seg = mmap(NULL, POOL_SEG, PROT_READ | PROT_WRITE, MAP_SHARED,
+			   pool.fd, pool.nsegs * POOL_SEG);
+	if (seg == MAP_FAILED)
+		err(4);
+	if (pool.spill)
+		madvise(seg, POOL_SEG, MADV_SEQUENTIAL);
+	pool.tick[pool.nsegs] = 0;
+	pool.segs[pool.nsegs++] = seg;
+}
+
+/**
+ * Allocates a stack node from the pool.
+
+ * @return: The node. Its fields are left for the caller to set.
+
+ * Freed nodes are reused first; otherwise the next node of the current
+ * segment is carved out, from the end of the segment towards its start.
+ */
+stack_t *pool_alloc(void)
+{
+	stack_t *node;
+
+	if (pool.free != NULL)
+	{
+		node = pool.free;
+		pool.free = node->next;
+		return (node);
+	}
+	if (pool.nsegs == 0 || pool.used == POOL_NODES)
+	{
+		if (pool.nsegs > 0)
+			pool.cur++;
+		if (pool.cur == pool.nsegs)
+			pool_grow();
+		pool.used = 0;
+		if (pool.spill)
+			pool_touch(pool.cur);
+	}
+	pool.used++;
+	return ((stack_t *)pool.segs[pool.cur] + POOL_NODES - pool.used);
+}
+
+/**
+ * Gives a stack node back to the pool.
+
+ * @param node: The node to free. The box of a boxed value is freed with it.
+ */
+void free_node(stack_t *node)
+{
+	if (node->tag != TAG_INT)
+		box_free(node->n);
+	node->next = pool.free;
+	pool.free = node;
+}
+
+/**
+ * Frees every node of the pool at once.
+
+ * The segments stay mapped and are reused from the first one, so emptying
+ * the stack does not depend on its size.
+ */
+void pool_reset(void)
+{
+	pool.free = NULL;
+	pool.cur = 0;
+	pool.used = 0;
+}
@@ -0,0 +1,87 @@
+#include "monty.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+/**
+ * Grows the instructions of a program kept in the spill code file.
+
+ * @param code: The instructions, NULL for a program not loaded yet.
+
+ * @param size: The new number of instructions.
+
+ * @return: The instructions, mapped from the file; they may have moved.
+
+ * Only one program at a time keeps its instructions in the file, the one
+ * at `pool.code`. The file grows sparse, only the pages written take room.
+ */
+code_t *pool_code_grow(code_t *code, size_t size)
+{
+	size_t len = size * sizeof(code_t);
+	void *map;
+
+	if (ftruncate(pool.cfd, len) == -1)
+		err(4);
+	if (code == NULL)
+		map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+			   pool.cfd, 0);
+	else
+		map = mremap(code, pool.csize, len, MREMAP_MAYMOVE);
+	if (map == MAP_FAILED)
+		err(4);
+	pool.code = map;
+	pool.csize = len;
+	return (map);
+}
+
+/**
+ * Drops a window of the instructions in the spill code file from memory.
+
+ * @param k: The index of the window, POOL_CODE bytes each.
+
+ * Its pages are written back and unmapped, as the segments of nodes are
+ * (see pool_evict); they are read back from the file if needed again.
+ */
+void pool_code_drop(size_t k)
+{
+	sync_file_range(pool.cfd, k * POOL_CODE, POOL_CODE,
+			SYNC_FILE_RANGE_WRITE);
+	madvise((char *)pool.code + k * POOL_CODE, POOL_CODE, MADV_DONTNEED);
+	posix_fadvise(pool.cfd, k * POOL_CODE, POOL_CODE, POSIX_FADV_DONTNEED);
+}
+
+/**
+ * Limits a run of instructions to the window of the spill code file it
+ * starts in.
+
+ * @param start: The first instruction of the run.
+
+ * @param end: The end of the run.
+
+ * @return: The end of the run, at most the end of the window.
+
+ * Programs have no jumps, so a window is never needed again once the run
+ * reaches the next one: it is dropped then, and at most one window of
+ * instructions stays in memory.
+ */
+code_t *pool_code_run(code_t *start, code_t *end)
+{
+	size_t i = start - pool.code;
+
+	if (i != 0 && i % POOL_CODE_LEN == 0)
+		pool_code_drop(i / POOL_CODE_LEN - 1);
+	i = (i / POOL_CODE_LEN + 1) * POOL_CODE_LEN;
+	return ((size_t)(end - pool.code) > i ? pool.code + i : end);
+}
+
+/**
+ * Releases the instructions kept in the spill code file.
+
+ * The file is emptied for the next program.
+ */
+void pool_code_free(void)
+{
+	munmap(pool.code, pool.csize);
+	pool.code = NULL;
+	pool.csize = 0;
+	ftruncate(pool.cfd, 0);
+}
@@ -0,0 +1,120 @@
+#include "monty.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+/**
+ * Creates an unlinked spill file.
+
+ * @param dir: The directory it is created in.
+
+ * @return: The file, open for reading and writing.
+ */
+static int spill_file(char *dir)
+{
+	char path[4096];
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/monty-spill-XXXXXX", dir);
+	fd = mkstemp(path);
+	if (fd == -1)
+		err(2, path);
+	unlink(path);
+	return (fd);
+}
+
+/**
+ * Moves the stack and the program to files and limits how much of them
+ * stays in memory.
+
+ * @param dir: The directory the spill files are created in.
+
+ * @param budget: The memory budget, as accepted by parse_size, or NULL for
+ * 256M. It must hold the window of instructions (POOL_CODE) and at least
+ * two segments of nodes, or the run stops with an error.
+
+ * Must be called before the first node is allocated.
+ */
+void pool_spill(char *dir, char *budget)
+{
+	unsigned long size = budget ? parse_size(budget) : 256UL << 20;
+
+	if (size < 2 * POOL_SEG + POOL_CODE)
+		err(23, budget, (2 * POOL_SEG + POOL_CODE) >> 20);
+	pool.fd = spill_file(dir);
+	pool.cfd = spill_file(dir);
+	pool.spill = 1;
+	pool.budget = (size - POOL_CODE) / POOL_SEG;
+}
+
+/**
+ * Drops a spill segment from memory.
+
+ * @param seg: The index of the segment.
+
+ * Writeback of its dirty pages is started, then the pages are unmapped and
+ * dropped from the page cache; they are read back from the file if needed.
+ */
+static void pool_evict(size_t seg)
+{
+	sync_file_range(pool.fd, seg * POOL_SEG, POOL_SEG,
+			SYNC_FILE_RANGE_WRITE);
+	madvise(pool.segs[seg], POOL_SEG, MADV_DONTNEED);
+	posix_fadvise(pool.fd, seg * POOL_SEG, POOL_SEG, POSIX_FADV_DONTNEED);
+	pool.tick[seg] = 0;
+}
+
+/**
+ * Records the use of a spill segment, evicting the least recently used ones over budget.
+
+ * @param seg: The index of the segment.
+ */
+void pool_touch(size_t seg)
+{
+	size_t i, lru, resident;
+
+	pool.tick[seg] = ++pool.clock;
+	for (;;)
+	{
+		resident = 0;
+		lru = seg;
+		for (i = 0; i < pool.nsegs; i++)
+		{
+			if (pool.tick[i] == 0)
+				continue;
+			resident++;
+			if (pool.tick[i] < pool.tick[lru])
+				lru = i;
+		}
+		if (resident <= pool.budget || lru == seg)
+			return;
+		pool_evict(lru);
+	}
+}
+
+/**
+ * Lets the pool follow a walk over the stack.
+
+ * @param node: The node the walk has reached.
+
+ * Called every POOL_WALK nodes by the functions walking the whole stack.
+ * The segment of `node` is marked as used, and the next segment of the walk
+ * (the older one, right before it) is read ahead.
+ */
+void pool_walk(stack_t *node)
+{
+	size_t i;
+
+	if (!pool.spill)
+		return;
+	for (i = 0; i < pool.nsegs; i++)
+	{
+		if ((char *)node >= pool.segs[i] &&
+		    (char *)node < pool.segs[i] + POOL_SEG)
+			break;
+	}
+	if (i == pool.nsegs || pool.tick[i] == pool.clock)
+		return;
+	pool_touch(i);
+	if (i > 0)
+		madvise(pool.segs[i - 1], POOL_SEG, MADV_WILLNEED);
+}
@@ -0,0 +1,186 @@
+#include "monty.h"
+
+/**
+ * Loads every line of an open file into a program.
+
+ * @param prog: The program to fill. Any previous content is ignored.
+
+ * @param fd: The file stream to read the instructions from.
+
+ * The program starts with a single, empty stack region; parse_line opens a
+ * new region each time a `stack` or `queue` directive changes the format.
+ * With `--opt`, dead instructions are then removed (see dce_program), and
+ * with `--ir` the program is lowered once they are gone.
+ */
+void load_program(program_t *prog, FILE *fd)
+{
+	int line_number;
+	char *buffer = NULL;
+	size_t len = 0;
+
+	memset(prog, 0, sizeof(*prog));
+	set_format(prog, 0);
+	for (line_number = 1; getline(&buffer, &len, fd) != -1; line_number++)
+		parse_line(prog, buffer, line_number);
+	free(buffer);
+	if (optimize)
+		dce_program(prog);
+	if (optimize && lower_ir)
+		ir_lower(prog);
+}
+
+/**
+ * Appends an instruction to the current region of a program.
+
+ * @param prog: The program being loaded.
+
+ * @param f: The handler of the instruction.
+
+ * @param n: The integer argument of the instruction.
+
+ * @param ln: The line number the instruction was read from.
+
+ * @param op: The opcode text. It must stay valid as long as the program.
+
+ * @return: The new instruction, for the caller to set its other operands.
+
+ * With `--ir` and without `--opt`, the instruction is lowered right away
+ * (see ir_add): only its handler and `n` are used, which the caller does
+ * not change afterwards except to turn it into another error instruction.
+
+ * With `--spill`, the instructions are kept in the spill code file when no
+ * other program keeps its own there, and each window of POOL_CODE bytes is
+ * dropped from memory once the next one is started.
+ */
+code_t *add_code(program_t *prog, op_func f, int n, int ln, char *op)
+{
+	code_t *code;
+
+	if (pool.spill && prog->code == pool.code && prog->len != 0 &&
+	    prog->len % POOL_CODE_LEN == 0)
+		pool_code_drop(prog->len / POOL_CODE_LEN - 1);
+	if (prog->len == prog->size)
+	{
+		prog->size = prog->size == 0 ? 64 : prog->size * 2;
+		if (pool.spill && prog->code == pool.code)
+			code = pool_code_grow(prog->code, prog->size);
+		else
+			code = realloc(prog->code, prog->size * sizeof(code_t));
+		if (code == NULL)
+			err(4);
+		prog->code = code;
+	}
+	code = &prog->code[prog->len++];
+	code->f = f;
+	code->n = n;
+	code->n2 = 0;
+	code->ln = ln;
+	code->op = op;
+	prog->regions[prog->nregions - 1].len++;
+	if (lower_ir && !optimize)
+		ir_add(prog, code);
+	return (code);
+}
+
+/**
+ * Switches the data format for the instructions loaded next.
+
+ * @param prog: The program being loaded.
+
+ * @param format: 0 to push as a stack (LIFO), 1 to push as a queue (FIFO).
+
+ * A new region is only started when the format actually changes and the
+ * current region already holds instructions.
+ */
+void set_format(program_t *prog, int format)
+{
+	region_t *region;
+
+	if (prog->nregions > 0)
+	{
+		region = &prog->regions[prog->nregions - 1];
+		if (region->format == format)
+			return;
+		if (region->len == 0)
+		{
+			region->format = format;
+			return;
+		}
+	}
+	if (prog->nregions == prog->rsize)
+	{
+		prog->rsize = prog->rsize == 0 ? 8 : prog->rsize * 2;
+		region = realloc(prog->regions, prog->rsize * sizeof(region_t));
+		if (region == NULL)
+			err(4);
+		prog->regions = region;
+	}
+	region = &prog->regions[prog->nregions++];
+	region->start = prog->len;
+	region->len = 0;
+	region->format = format;
+}
+
+/**
+ * Releases the memory held by a program.
+
+ * @param prog: The program to free.
+
+ * Only the opcode text of unknown instructions and the digits of large
+ * `push` arguments were allocated by the loader, known opcodes point to
+ * static strings. Instructions kept in the spill code file are dropped as
+ * they are walked, then unmapped.
+ */
+void free_program(program_t *prog)
+{
+	size_t i;
+
+	for (i = 0; i < prog->len; i++)
+	{
+		if (prog->code[i].f == bad_op ||
+		    prog->code[i].f == push_big_stack ||
+		    prog->code[i].f == push_big_queue)
+			free(prog->code[i].op);
+		if (prog->code == pool.code && (i + 1) % POOL_CODE_LEN == 0)
+			pool_code_drop(i / POOL_CODE_LEN);
+	}
+	if (prog->code != NULL && prog->code == pool.code)
+		pool_code_free();
+	else
+		free(prog->code);
+	free(prog->regions);
+	free(prog->ir.ops);
+	memset(prog, 0, sizeof(*prog));
+}
+
+/**
+ * Removes instructions from a loaded program.
+
+ * @param prog: The program, not started yet.
+
+ * @param keep: For each instruction, 0 to remove it.
+
+ * @return: The number of instructions removed.
+
+ * The instructions left keep their order and line numbers; the regions
+ * shrink around them and may become empty.
+ */
+size_t compact_program(program_t *prog, char *keep)
+{
+	size_t r, i, end, len = 0;
+
+	for (r = 0; r < prog->nregions; r++)
+	{
+		end = prog->regions[r].start + prog->regions[r].len;
+		prog->regions[r].start = len;
+		for (i = end - prog->regions[r].len; i < end; i++)
+		{
+			if (keep[i])
+				prog->code[len++] = prog->code[i];
+		}
+		prog->regions[r].len = len - prog->regions[r].start;
+	}
+	i = prog->len - len;
+	prog->len = len;
+	return (i);
+}
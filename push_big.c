@@ -0,0 +1,39 @@
+#include "monty.h"
+
+/**
+ * Pushes an argument too large for an int on top of the stack.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param ln: The line number of the instruction.
+
+ * The loader keeps the digits of such an argument in the `op` of the
+ * instruction; they are converted when the instruction runs, which
+ * happens once since programs are straight-line.
+ */
+void push_big_stack(stack_t **stack, unsigned int ln)
+{
+	stack_t *node;
+
+	(void)stack;
+	node = create_node(0);
+	num_parse(node, pc->op);
+	add_to_stack(&node, ln);
+}
+
+/**
+ * Adds an argument too large for an int at the back of the queue.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param ln: The line number of the instruction.
+ */
+void push_big_queue(stack_t **stack, unsigned int ln)
+{
+	stack_t *node;
+
+	(void)stack;
+	node = create_node(0);
+	num_parse(node, pc->op);
+	add_to_queue(&node, ln);
+}
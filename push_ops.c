@@ -0,0 +1,63 @@
+#include "monty.h"
+
+/**
+ * Pushes the argument of the running instruction on top of the stack.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param ln: The line number of the instruction.
+
+ * This is the `push` handler of stack regions: the new node becomes the top.
+ */
+void push_stack(stack_t **stack, unsigned int ln)
+{
+	stack_t *node;
+
+	(void)stack;
+	node = create_node(pc->n);
+	add_to_stack(&node, ln);
+}
+
+/**
+ * Pushes the argument of the running instruction at the back of the queue.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param ln: The line number of the instruction.
+
+ * This is the `push` handler of queue regions: the new node becomes the last.
+ */
+void push_queue(stack_t **stack, unsigned int ln)
+{
+	stack_t *node;
+
+	(void)stack;
+	node = create_node(pc->n);
+	add_to_queue(&node, ln);
+}
+
+/**
+ * Reports an unknown instruction once execution reaches it.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack (unused).
+
+ * @param ln: The line number of the instruction.
+ */
+void bad_op(stack_t **stack, unsigned int ln)
+{
+	(void)stack;
+	err(3, ln, pc->op);
+}
+
+/**
+ * Reports a `push` without a valid integer once execution reaches it.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack (unused).
+
+ * @param ln: The line number of the instruction.
+ */
+void bad_push(stack_t **stack, unsigned int ln)
+{
+	(void)stack;
+	err(5, ln);
+}
@@ -0,0 +1,85 @@
+#include "monty.h"
+
+stack_t *regs;
+
+/**
+ * Gives the registers of the running script, allocating them if needed.
+
+ * @return: The MONTY_REGS registers.
+
+ * A script gets its registers on its first `store`; until then `regs` is
+ * NULL and every register reads as 0.
+ */
+stack_t *reg_bank(void)
+{
+	if (regs == NULL)
+		regs = calloc(MONTY_REGS, sizeof(*regs));
+	if (regs == NULL)
+		err(4);
+	return (regs);
+}
+
+/**
+ * Pops the top element of the stack into a register.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * The register number is the argument of the instruction, from 0 to
+ * MONTY_REGS - 1. Registers start at 0. A register is a node outside of any
+ * list, so a boxed value moves into it without being copied.
+ */
+void store_reg(stack_t **stack, unsigned int line_number)
+{
+	if (pc->n < 0 || pc->n >= MONTY_REGS)
+		more_err(19, line_number, pc->n);
+	if (*stack == NULL)
+		more_err(18, line_number, "store");
+	num_move(&reg_bank()[pc->n], *stack);
+	pop_top(stack, line_number);
+}
+
+/**
+ * Pushes the value of a register on top of the stack.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * This is the `load` handler of stack regions; the register is kept.
+ */
+void load_stack(stack_t **stack, unsigned int line_number)
+{
+	stack_t *node;
+
+	(void)stack;
+	if (pc->n < 0 || pc->n >= MONTY_REGS)
+		more_err(19, line_number, pc->n);
+	node = create_node(0);
+	if (regs != NULL)
+		num_copy(node, &regs[pc->n]);
+	add_to_stack(&node, line_number);
+}
+
+/**
+ * Adds the value of a register at the back of the queue.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * This is the `load` handler of queue regions; the register is kept.
+ */
+void load_queue(stack_t **stack, unsigned int line_number)
+{
+	stack_t *node;
+
+	(void)stack;
+	if (pc->n < 0 || pc->n >= MONTY_REGS)
+		more_err(19, line_number, pc->n);
+	node = create_node(0);
+	if (regs != NULL)
+		num_copy(node, &regs[pc->n]);
+	add_to_queue(&node, line_number);
+}
@@ -0,0 +1,65 @@
+#include "monty.h"
+
+/**
+ * Executes a loaded program from its current position to the end.
+
+ * @param prog: The program to execute.
+ */
+void run_program(program_t *prog)
+{
+	run_steps(prog, (size_t)-1);
+}
+
+/**
+ * Executes at most `limit` instructions of a program, one region after the other.
+
+ * @param prog: The program to execute, resumed at `prog->pos`.
+
+ * @param limit: The maximum number of instructions to execute.
+
+ * @return: The number of instructions executed.
+
+ * Every `push` was already resolved for the format of its region, so the
+ * inner loop runs the same way for stack and queue regions, and the limit is
+ * only checked once per region. The global `pc` points to the running
+ * instruction, handlers read their argument from it. Instructions kept in
+ * the spill code file run one window at a time (see pool_code_run).
+ */
+size_t run_steps(program_t *prog, size_t limit)
+{
+	region_t *region;
+	code_t *start, *end;
+	size_t done = 0;
+
+	while (prog->pos < prog->len && done < limit)
+	{
+		region = &prog->regions[prog->reg];
+		start = prog->code + prog->pos;
+		end = prog->code + region->start + region->len;
+		if ((size_t)(end - start) > limit - done)
+			end = start + (limit - done);
+		if (prog->code == pool.code)
+			end = pool_code_run(start, end);
+		for (pc = start; pc < end; pc++)
+			pc->f(&head, pc->ln);
+		done += end - start;
+		prog->pos += end - start;
+		if (prog->pos == region->start + region->len)
+			prog->reg++;
+	}
+	return (done);
+}
+
+/**
+ * Ends the running program after an error was reported.
+
+ * The stack is freed. When an error handler was installed with `fail_jmp`
+ * (server mode), control goes back to it; otherwise the process exits.
+ */
+void die(void)
+{
+	free_nodes();
+	if (fail_jmp != NULL)
+		longjmp(*fail_jmp, 1);
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,190 @@
+#include "monty.h"
+#include <time.h>
+
+/**
+ * Writes the output of a finished task and frees it.
+
+ * @param t: The task.
+
+ * @return: 1 if the task failed, 0 otherwise.
+
+ * Its output goes to stdout after a `==> name <==` line, and its error
+ * message, if any, to stderr as `name: <message>`.
+ */
+static int sched_finish(task_t *t)
+{
+	task_state_t *s = t->run;
+	int failed;
+
+	fclose(s->out);
+	fclose(s->errs);
+	failed = s->elen > 0;
+	printf("==> %s <==\n", t->name);
+	fwrite(s->obuf, 1, s->olen, stdout);
+	if (failed)
+		fprintf(stderr, "%s: %s", t->name, s->ebuf);
+	free(s->obuf);
+	free(s->ebuf);
+	free(t->name);
+	free_program(&s->prog);
+	free(s);
+	t->run = NULL;
+	return (failed);
+}
+
+/**
+ * Gives a task one turn of at most `quantum` instructions.
+
+ * @param t: The task.
+
+ * @param quantum: The length of a turn.
+
+ * @return: 1 if the task ended during its turn, 0 otherwise.
+
+ * The global interpreter state (`head`, the output streams, the error
+ * handler) is switched to the task for the turn and saved back after it.
+ * The first turn loads the script. Programs are straight-line, so the
+ * instructions executed so far are the position in the program (plus the
+ * failing one after an error).
+ */
+static int sched_turn(task_t *t, size_t quantum)
+{
+	jmp_buf env;
+	volatile int done = 1;
+	task_state_t *s;
+	FILE *src;
+
+	if (t->run == NULL)
+		sched_start(t);
+	s = t->run;
+	head = s->head;
+	regs = s->regs;
+	idx_reset();
+	out_stream = s->out;
+	err_stream = s->errs;
+	fail_jmp = &env;
+	if (setjmp(env) == 0)
+	{
+		src = t->quanta == 0 ? fopen(t->name, "r") : NULL;
+		if (t->quanta == 0 && src == NULL)
+			err(2, t->name);
+		if (src != NULL)
+		{
+			load_program(&s->prog, src);
+			fclose(src);
+		}
+		run_steps(&s->prog, quantum);
+		t->steps = s->prog.pos;
+		done = s->prog.pos == s->prog.len;
+		if (done)
+			free_nodes();
+	}
+	else
+		t->steps = s->prog.len == 0 ? 0 : pc - s->prog.code + 1;
+	fail_jmp = NULL;
+	s->head = head;
+	s->regs = regs;
+	t->quanta++;
+	return (done);
+}
+
+/**
+ * Prints the statistics of a scheduler run on stderr.
+
+ * @param tasks: The tasks, all finished.
+
+ * @param count: The number of tasks.
+
+ * @param turns: The number of turns given.
+
+ * @param start: When the run started.
+
+ * The fairness is Jain's index of the average wait between two turns of
+ * every task that had more than one, counted in instructions executed by
+ * the other tasks: 1 when every task waits as long, 1/n when one task hogs
+ * the processor.
+ */
+static void sched_stats(task_t *tasks, size_t count, unsigned long turns,
+			struct timespec *start)
+{
+	struct timespec end;
+	double secs, w, sum = 0, sq = 0, steps = 0, maxw = 0;
+	size_t i, n;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	secs = (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+	for (i = 0, n = 0; i < count; i++)
+	{
+		steps += tasks[i].steps;
+		if (tasks[i].quanta < 2)
+			continue;
+		w = (double)tasks[i].wait / (tasks[i].quanta - 1);
+		sum += w;
+		sq += w * w;
+		maxw = w > maxw ? w : maxw;
+		n++;
+	}
+	fprintf(stderr, "sched: %lu tasks, %.0f instructions, %lu turns\n",
+		(unsigned long)count, steps, turns);
+	fprintf(stderr, "sched: %.3f s, %.0f instructions/s, %.0f ns/turn\n",
+		secs, secs > 0 ? steps / secs : 0, turns ? secs * 1e9 / turns : 0);
+	fprintf(stderr, "sched: wait/turn mean %.0f max %.0f, fairness %.4f\n",
+		n ? sum / n : 0, maxw, sq > 0 ? sum * sum / (n * sq) : 1);
+}
+
+/**
+ * Runs many scripts side by side on one thread.
+
+ * @param opts: The options; `file` lists the scripts, `quantum` is the
+ * number of instructions per turn (1000 by default), `stats` asks for
+ * statistics.
+
+ * @return: EXIT_SUCCESS if every script succeeded, EXIT_FAILURE otherwise.
+
+ * Each script is a task with its own stack and output buffers. Tasks take
+ * turns in round-robin order until they all end; a task is written out and
+ * freed as soon as it ends.
+ */
+int run_sched(options_t *opts)
+{
+	size_t count, live, i, j, quantum = 1000;
+	unsigned long clock = 0, turns = 0, before;
+	struct timespec start;
+	task_t *tasks, *t, **ring;
+	int failed = 0;
+
+	if (opts->quantum != NULL && atol(opts->quantum) > 0)
+		quantum = atol(opts->quantum);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	tasks = sched_load(opts->file, &count);
+	ring = malloc((count + 1) * sizeof(task_t *));
+	if (ring == NULL)
+		err(4);
+	for (i = 0; i < count; i++)
+		ring[i] = &tasks[i];
+	pool.shared = 1;
+	for (live = count; live > 0; live = j)
+	{
+		for (i = 0, j = 0; i < live; i++, turns++)
+		{
+			t = ring[i];
+			if (t->quanta > 0)
+				t->wait += clock - t->last;
+			before = t->steps;
+			if (sched_turn(t, quantum))
+				failed |= sched_finish(t);
+			else
+				ring[j++] = t;
+			clock += t->steps - before;
+			t->last = clock;
+		}
+	}
+	fail_jmp = NULL;
+	out_stream = stdout;
+	err_stream = stderr;
+	if (opts->stats != NULL)
+		sched_stats(tasks, count, turns, &start);
+	free(ring);
+	free(tasks);
+	return (failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,69 @@
+#include "monty.h"
+
+/**
+ * Reads the list of scripts to run as tasks.
+
+ * @param list: The path of the file listing one script path per line.
+
+ * @param count: Receives the number of tasks.
+
+ * @return: The tasks, in the order of the list.
+
+ * Only the names are kept: the scripts are loaded on their first turn (see
+ * sched_start), so a task costs nothing more until then.
+ */
+task_t *sched_load(char *list, size_t *count)
+{
+	FILE *fd = fopen(list, "r");
+	char *line = NULL;
+	size_t len = 0, size = 0;
+	task_t *tasks = NULL, *t;
+
+	if (fd == NULL)
+		err(2, list);
+	for (*count = 0; getline(&line, &len, fd) != -1; )
+	{
+		line[strcspn(line, "\n")] = '\0';
+		if (line[0] == '\0')
+			continue;
+		if (*count == size)
+		{
+			size = size == 0 ? 64 : size * 2;
+			tasks = realloc(tasks, size * sizeof(task_t));
+			if (tasks == NULL)
+				err(4);
+		}
+		t = &tasks[(*count)++];
+		memset(t, 0, sizeof(*t));
+		t->name = strdup(line);
+		if (t->name == NULL)
+			err(4);
+	}
+	free(line);
+	fclose(fd);
+	return (tasks);
+}
+
+/**
+ * Allocates the state of a task for its first turn.
+
+ * @param t: The task.
+
+ * The output streams keep pointers to their buffer fields, which do not
+ * move since every state is allocated on its own. The script itself is
+ * loaded during the turn, so that a script that cannot be opened fails as
+ * a task instead of stopping the others.
+ */
+void sched_start(task_t *t)
+{
+	task_state_t *s;
+
+	s = calloc(1, sizeof(*s));
+	if (s == NULL)
+		err(4);
+	s->out = open_memstream(&s->obuf, &s->olen);
+	s->errs = open_memstream(&s->ebuf, &s->elen);
+	if (s->out == NULL || s->errs == NULL)
+		err(4);
+	t->run = s;
+}
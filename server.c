@@ -0,0 +1,212 @@
+#include "signals.h"
+#include "monty.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * Writes a whole buffer to a client.
+
+ * @param fd: The client socket.
+
+ * @param buf: The bytes to send.
+
+ * @param len: The number of bytes.
+
+ * @return: 0 on success, -1 if the client went away.
+ */
+static int send_all(int fd, const char *buf, size_t len)
+{
+	ssize_t n;
+
+	for (; len > 0; buf += n, len -= n)
+	{
+		n = send(fd, buf, len, MSG_NOSIGNAL);
+		if (n <= 0)
+			return (-1);
+	}
+	return (0);
+}
+
+/**
+ * Runs one submitted script in a fresh interpreter state.
+
+ * @param req: The path of the script, or its text.
+
+ * @param len: The length of the inline text, SERVE_PATH for a path.
+
+ * @param budget: The maximum number of instructions to execute.
+
+ * @param out: The stream receiving what the script prints.
+
+ * @param errs: The stream receiving the error message, if any.
+
+ * @return: The exit status the script would have had when run by monty.
+
+ * The state is reset in constant time: the stack is dropped with the node
+ * pool (see free_nodes) instead of being walked. Errors come back here
+ * through `fail_jmp` instead of exiting the server.
+ */
+int serve_request(char *req, size_t len, size_t budget, FILE *out, FILE *errs)
+{
+	static program_t prog;
+	volatile int status = EXIT_SUCCESS;
+	jmp_buf env;
+	FILE *src;
+
+	memset(&prog, 0, sizeof(prog));
+	out_stream = out;
+	err_stream = errs;
+	fail_jmp = &env;
+	if (setjmp(env) == 0)
+	{
+		if (len == SERVE_PATH)
+			src = fopen(req, "r");
+		else
+			src = fmemopen(len ? req : "", len, "r");
+		if (src == NULL)
+			err(2, len == SERVE_PATH ? req : "(inline)");
+		load_program(&prog, src);
+		fclose(src);
+		if (run_steps(&prog, budget) == budget && prog.pos < prog.len)
+			more_err(14, prog.code[prog.pos].ln);
+		free_nodes();
+	}
+	else
+		status = EXIT_FAILURE;
+	fail_jmp = NULL;
+	out_stream = stdout;
+	err_stream = stderr;
+	free_program(&prog);
+	return (status);
+}
+
+/**
+ * Serves the requests of one client until it disconnects.
+
+ * @param fd: The client socket.
+
+ * @param budget: The instruction budget of each request.
+
+ * A request is either `run <path>\n` or `eval <length>\n` followed by the
+ * script itself. The answer is `<status> <stdout length> <stderr length>\n`
+ * followed by the stdout and the stderr bytes of the run. `eval 0` runs
+ * an empty script, which succeeds without output.
+ */
+static void serve_conn(int fd, size_t budget)
+{
+	FILE *in = fdopen(fd, "r"), *out, *errs;
+	char *line = NULL, *body = NULL, *obuf, *ebuf, head[64];
+	size_t len = 0, olen, elen, n;
+	int status;
+
+	while (in != NULL && getline(&line, &len, in) > 0)
+	{
+		line[strcspn(line, "\n")] = '\0';
+		n = SERVE_PATH;
+		if (strncmp(line, "eval ", 5) == 0)
+		{
+			n = strtoul(line + 5, NULL, 10);
+			if (n == SERVE_PATH)
+				break;
+			body = realloc(body, n + 1);
+			if (body == NULL || fread(body, 1, n, in) != n)
+				break;
+		}
+		else if (strncmp(line, "run ", 4) != 0)
+			break;
+		out = open_memstream(&obuf, &olen);
+		errs = open_memstream(&ebuf, &elen);
+		if (out == NULL || errs == NULL)
+			break;
+		status = serve_request(n == SERVE_PATH ? line + 4 : body, n,
+			budget, out, errs);
+		fclose(out);
+		fclose(errs);
+		sprintf(head, "%d %lu %lu\n", status, (unsigned long)olen,
+			(unsigned long)elen);
+		n = send_all(fd, head, strlen(head)) || send_all(fd, obuf, olen) ||
+			send_all(fd, ebuf, elen);
+		free(obuf);
+		free(ebuf);
+		if (n)
+			break;
+	}
+	free(line);
+	free(body);
+	if (in != NULL)
+		fclose(in);
+	else
+		close(fd);
+}
+
+/**
+ * Accepts and serves clients forever, one at a time.
+
+ * @param sfd: The listening socket.
+
+ * @param budget: The instruction budget of each request.
+ */
+static void server_worker(int sfd, size_t budget)
+{
+	int fd;
+
+	for (;;)
+	{
+		fd = accept(sfd, NULL, NULL);
+		if (fd != -1)
+			serve_conn(fd, budget);
+	}
+}
+
+/**
+ * Runs monty as a server listening on a Unix domain socket.
+
+ * @param opts: The options; `serve` is the socket path, `workers` the
+ * number of requests served at once (4 by default) and `budget` the number
+ * of instructions a request may execute (unlimited by default).
+
+ * @return: EXIT_FAILURE if the server could not start; it never returns
+ * otherwise.
+
+ * The workers are forked once, each serving its clients in its own process;
+ * a worker that dies (killed by a signal) is replaced. Only the workers that
+ * were forked are counted: a failed fork is tried again a second later,
+ * the clients waiting in the backlog meanwhile.
+ */
+int run_server(options_t *opts)
+{
+	struct sockaddr_un addr;
+	size_t budget = (size_t)-1;
+	int sfd, workers = 4, live;
+	pid_t pid;
+
+	if (opts->workers != NULL)
+		workers = atoi(opts->workers);
+	if (opts->budget != NULL)
+		budget = strtoul(opts->budget, NULL, 10);
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, opts->serve, sizeof(addr.sun_path) - 1);
+	sfd = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(opts->serve);
+	if (sfd == -1 || workers < 1 ||
+	    bind(sfd, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+	    listen(sfd, 128) == -1)
+		err(2, opts->serve);
+	for (live = 0; ; )
+	{
+		while (live < workers && (pid = fork()) != -1)
+		{
+			if (pid == 0)
+				server_worker(sfd, budget);
+			live++;
+		}
+		pid = waitpid(-1, NULL, live < workers ? WNOHANG : 0);
+		if (pid == -1)
+			return (EXIT_FAILURE);
+		if (pid > 0)
+			live--;
+		else
+			sleep(1);
+	}
+}
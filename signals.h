@@ -0,0 +1,16 @@
+#ifndef SIGNALS_H
+#define SIGNALS_H
+
+/*
+ * <signal.h> has its own stack_t, which clashes with the stack node of
+ * monty.h: include this header before monty.h, rather than <signal.h> or
+ * <sys/wait.h> (which pulls it in), and its stack_t is sig_stack_t.
+ * Being included first, it also asks for the GNU extensions monty.h uses.
+ */
+#define _GNU_SOURCE
+#define stack_t sig_stack_t
+#include <signal.h>
+#include <sys/wait.h>
+#undef stack_t
+
+#endif
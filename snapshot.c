@@ -0,0 +1,220 @@
+#include "monty.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+
+/**
+ * Adds one loaded instruction to a running program hash (FNV-1a).
+
+ * @param h: The hash of the instructions before this one.
+
+ * @param code: The instruction.
+
+ * @param format: The format of the region holding the instruction.
+
+ * @return: The hash including the instruction.
+
+ * Only what the instruction does is hashed: its opcode text, arguments and
+ * format. Line numbers are left out, so adding comments to a script does
+ * not invalidate its snapshots.
+ */
+unsigned long code_hash(unsigned long h, code_t *code, int format)
+{
+	const unsigned char *s = (const unsigned char *)code->op;
+	unsigned int v = code->n, v2 = code->n2;
+	int i;
+
+	for (; *s != '\0'; s++)
+		h = (h ^ *s) * 1099511628211UL;
+	for (i = 0; i < 4; i++, v >>= 8, v2 >>= 8)
+		h = (((h ^ (v & 0xff)) * 1099511628211UL) ^ (v2 & 0xff)) *
+			1099511628211UL;
+	h = (h ^ (format | (code->f == bad_push) << 1 |
+		  (code->f == bad_bulk) << 2)) * 1099511628211UL;
+	return (h);
+}
+
+/**
+ * Hashes the interpreter version and every instruction of a program.
+
+ * @param prog: The loaded program.
+
+ * @return: The key identifying the program in its snapshots.
+ */
+unsigned long prog_key(program_t *prog)
+{
+	const unsigned char *v = (const unsigned char *)MONTY_VERSION;
+	unsigned long h = 14695981039346656037UL;
+	size_t i, r;
+
+	for (i = 0; i < sizeof(MONTY_VERSION); i++)
+		h = (h ^ v[i]) * 1099511628211UL;
+	for (r = 0; r < prog->nregions; r++)
+	{
+		for (i = 0; i < prog->regions[r].len; i++)
+			h = code_hash(h, &prog->code[prog->regions[r].start + i],
+				      prog->regions[r].format);
+	}
+	return (h);
+}
+
+/**
+ * Lays out the state of a running program as a snapshot.
+
+ * @param prog: The program, stopped at `prog->pos`.
+
+ * @param hdr: The header to use; `depth` is filled in here.
+
+ * @param buf: The buffer receiving the snapshot, grown as needed.
+
+ * @param cap: The allocated size of `buf`.
+
+ * @return: The size of the snapshot in bytes.
+
+ * The header is followed by the values of the stack, top first, then by
+ * the registers, packed by num_pack: an int value takes one int. The buffer
+ * is kept by the caller and reused, so a checkpoint costs two walks of the
+ * stack and no allocation once the stack stops growing.
+ */
+size_t snap_pack(program_t *prog, snap_hdr_t *hdr, char **buf, size_t *cap)
+{
+	stack_t *node;
+	size_t depth = 0, words = 0, size, i;
+	int *val;
+
+	for (node = head; node != NULL; node = node->next, depth++)
+		words += num_pack(node, NULL);
+	for (i = 0; i < MONTY_REGS; i++)
+		words += num_pack(&reg_bank()[i], NULL);
+	size = sizeof(*hdr) + words * sizeof(int);
+	if (size > *cap)
+	{
+		free(*buf);
+		*cap = size * 2;
+		*buf = malloc(*cap);
+		if (*buf == NULL)
+			err(4);
+	}
+	memcpy(hdr->magic, SNAP_MAGIC, 8);
+	hdr->pos = prog->pos;
+	hdr->format = prog->pos < prog->len ? prog->regions[prog->reg].format : 0;
+	hdr->depth = depth;
+	hdr->words = words;
+	memcpy(*buf, hdr, sizeof(*hdr));
+	val = (int *)(*buf + sizeof(*hdr));
+	for (node = head; node != NULL; node = node->next)
+		val += num_pack(node, val);
+	for (i = 0; i < MONTY_REGS; i++)
+		val += num_pack(&reg_bank()[i], val);
+	return (size);
+}
+
+/**
+ * Writes a snapshot to a file, replacing it atomically.
+
+ * @param path: The path of the snapshot.
+
+ * @param buf: The snapshot, see snap_pack.
+
+ * @param size: The size of the snapshot.
+
+ * @return: 0 on success, -1 on failure.
+
+ * The snapshot goes to `path.tmp` in a single write (only split when it
+ * is over the 2G a write may transfer) and is renamed over
+ * `path` once it reached the disk, so `path` always holds a whole snapshot.
+ */
+int snap_save(char *path, char *buf, size_t size)
+{
+	char tmp[4096];
+	ssize_t n = 0;
+	int fd, ok;
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1)
+		return (-1);
+	while (size > 0 && (n = write(fd, buf, size)) > 0)
+	{
+		buf += n;
+		size -= n;
+	}
+	ok = size == 0 && fdatasync(fd) == 0;
+	if (close(fd) == -1 || !ok || rename(tmp, path) == -1)
+	{
+		unlink(tmp);
+		return (-1);
+	}
+	return (0);
+}
+
+/**
+ * Restores the state of a program from a snapshot.
+
+ * @param path: The path of the snapshot.
+
+ * @param prog: The loaded program, its position is set from the snapshot.
+
+ * @param hdr: Holds the expected key; receives the header of the snapshot.
+
+ * @return: 0 on success, -1 if the snapshot cannot be read or does not
+ * belong to this program.
+
+ * The packed values are checked and located first; the stack is then
+ * rebuilt bottom first, so its nodes are laid out in the pool as if they
+ * had been pushed. Anything stored after the values is left to the caller.
+ */
+int snap_load(char *path, program_t *prog, snap_hdr_t *hdr)
+{
+	unsigned long key = hdr->key;
+	size_t i, w, *off = NULL;
+	stack_t *node;
+	struct stat st;
+	int fd, ok, *val;
+	ssize_t n;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return (-1);
+	ok = fstat(fd, &st) == 0 && read(fd, hdr, sizeof(*hdr)) == sizeof(*hdr) &&
+		memcmp(hdr->magic, SNAP_MAGIC, 8) == 0 && hdr->key == key &&
+		hdr->pos <= prog->len && hdr->depth <= hdr->words &&
+		(size_t)st.st_size >= sizeof(*hdr) + hdr->words * sizeof(int);
+	val = ok ? malloc(hdr->words * sizeof(int) + 1) : NULL;
+	off = val != NULL ? malloc((hdr->depth + 1) * sizeof(size_t)) : NULL;
+	ok = ok && off != NULL;
+	for (i = 0, n = 1; ok && i < hdr->words * sizeof(int) && n > 0; i += n)
+		n = read(fd, (char *)val + i, hdr->words * sizeof(int) - i);
+	ok = ok && n > 0;
+	close(fd);
+	for (i = 0, w = 0; ok && i < hdr->depth + MONTY_REGS; i++, w += n)
+	{
+		if (i <= hdr->depth)
+			off[i] = w;
+		n = num_unpack(NULL, val + w, hdr->words - w);
+		ok = n > 0;
+	}
+	ok = ok && w == hdr->words;
+	for (prog->reg = 0; ok && prog->reg + 1 < prog->nregions &&
+	     prog->regions[prog->reg + 1].start <= hdr->pos; prog->reg++)
+		;
+	if (ok && hdr->pos < prog->len)
+		ok = prog->regions[prog->reg].format == hdr->format;
+	for (i = hdr->depth; ok && i > 0; i--)
+	{
+		node = create_node(0);
+		num_unpack(node, val + off[i - 1], hdr->words - off[i - 1]);
+		node->next = head;
+		if (head != NULL)
+			head->prev = node;
+		head = node;
+	}
+	for (i = 0, w = ok ? off[hdr->depth] : 0; ok && i < MONTY_REGS; i++)
+		w += num_unpack(&reg_bank()[i], val + w, hdr->words - w);
+	free(val);
+	free(off);
+	if (!ok)
+		return (-1);
+	prog->pos = hdr->pos;
+	idx_reset();
+	return (0);
+}
@@ -46,6 +46,7 @@ void add_to_stack(stack_t **new_node, __attribute__((unused))unsigned int ln)
  * @param line_number: (Optional) Line number where the print operation was encountered (for debugging).
 
  * This function iterates through the stack, starting from the top element, and prints the data stored in each node.
+ * Large stacks are formatted by several threads instead (see pall_parallel).
 
  * Note: The specific format and additional information printed might differ based on your program logic.
 
@@ -53,15 +54,20 @@ void add_to_stack(stack_t **new_node, __attribute__((unused))unsigned int ln)
 void print_stack(stack_t **stack, unsigned int line_number)
 {
 	stack_t *tmp;
+	size_t i;
 
 	(void) line_number;
 	if (stack == NULL)
 		exit(EXIT_FAILURE);
+	if (pall_parallel(*stack) == 0)
+		return;
 	tmp = *stack;
-	while (tmp != NULL)
+	for (i = 1; tmp != NULL; i++)
 	{
-		printf("%d\n", tmp->n);
+		num_print(out_stream, tmp);
 		tmp = tmp->next;
+		if ((i & POOL_WALK) == 0)
+			pool_walk(tmp);
 	}
 }
 
@@ -93,7 +99,7 @@ void pop_top(stack_t **stack, unsigned int line_number)
 	*stack = tmp->next;
 	if (*stack != NULL)
 		(*stack)->prev = NULL;
-	free(tmp);
+	free_node(tmp);
 }
 
 /**
@@ -114,5 +120,5 @@ void print_top(stack_t **stack, unsigned int line_number)
 {
 	if (stack == NULL || *stack == NULL)
 		more_err(6, line_number);
-	printf("%d\n", (*stack)->n);
+	num_print(out_stream, *stack);
 }
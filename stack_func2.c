@@ -80,6 +80,8 @@ void swap_nodes(stack_t **stack, unsigned int line_number)
  * - The specific data type stored within the nodes for clarity.
  * - Any potential overflow handling for large values.
 
+ * On overflow, or when an operand is boxed, the result is computed by
+ * num_arith and promoted to a 64-bit or bignum value as needed.
  */
 void add_nodes(stack_t **stack, unsigned int line_number)
 {
@@ -89,9 +91,12 @@ void add_nodes(stack_t **stack, unsigned int line_number)
 		more_err(8, line_number, "add");
 
 	(*stack) = (*stack)->next;
-	sum = (*stack)->n + (*stack)->prev->n;
-	(*stack)->n = sum;
-	free((*stack)->prev);
+	if (((*stack)->tag | (*stack)->prev->tag) != TAG_INT ||
+	    __builtin_add_overflow((*stack)->n, (*stack)->prev->n, &sum))
+		num_arith(*stack, (*stack)->prev, '+');
+	else
+		(*stack)->n = sum;
+	free_node((*stack)->prev);
 	(*stack)->prev = NULL;
 }
 
@@ -121,6 +126,8 @@ void add_nodes(stack_t **stack, unsigned int line_number)
  * - The specific data type stored within the nodes for clarity.
  * - Any potential overflow handling for large values or negative results.
 
+ * On overflow, or when an operand is boxed, the result is computed by
+ * num_arith and promoted to a 64-bit or bignum value as needed.
  */
 void sub_nodes(stack_t **stack, unsigned int line_number)
 {
@@ -132,9 +139,12 @@ void sub_nodes(stack_t **stack, unsigned int line_number)
 
 
 	(*stack) = (*stack)->next;
-	sum = (*stack)->n - (*stack)->prev->n;
-	(*stack)->n = sum;
-	free((*stack)->prev);
+	if (((*stack)->tag | (*stack)->prev->tag) != TAG_INT ||
+	    __builtin_sub_overflow((*stack)->n, (*stack)->prev->n, &sum))
+		num_arith(*stack, (*stack)->prev, '-');
+	else
+		(*stack)->n = sum;
+	free_node((*stack)->prev);
 	(*stack)->prev = NULL;
 }
 
@@ -165,6 +175,8 @@ void sub_nodes(stack_t **stack, unsigned int line_number)
  * - The specific data type stored within the nodes for clarity.
  * - Any specific rounding behavior employed for the quotient.
 
+ * Boxed operands go through num_arith, as does INT_MIN / -1, whose result
+ * needs 64 bits.
  */
 void div_nodes(stack_t **stack, unsigned int line_number)
 {
@@ -173,11 +185,17 @@ void div_nodes(stack_t **stack, unsigned int line_number)
 	if (stack == NULL || *stack == NULL || (*stack)->next == NULL)
 		more_err(8, line_number, "div");
 
-	if ((*stack)->n == 0)
+	if ((*stack)->tag == TAG_INT && (*stack)->n == 0)
 		more_err(9, line_number);
 	(*stack) = (*stack)->next;
-	sum = (*stack)->n / (*stack)->prev->n;
-	(*stack)->n = sum;
-	free((*stack)->prev);
+	if (((*stack)->tag | (*stack)->prev->tag) != TAG_INT ||
+	    (*stack)->prev->n == -1)
+		num_arith(*stack, (*stack)->prev, '/');
+	else
+	{
+		sum = (*stack)->n / (*stack)->prev->n;
+		(*stack)->n = sum;
+	}
+	free_node((*stack)->prev);
 	(*stack)->prev = NULL;
 }
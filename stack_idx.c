@@ -0,0 +1,133 @@
+#include "monty.h"
+
+stack_idx_t stack_idx = {NULL, NULL, NULL, 0, 0, 0, NULL, NULL, 0};
+
+/**
+ * Adds to the count of a block in the Fenwick tree.
+
+ * @param b: The block.
+
+ * @param delta: The change, wrapping around for removals.
+ */
+static void fen_add(size_t b, size_t delta)
+{
+	for (b++; b <= stack_idx.cap; b += b & (0 - b))
+		stack_idx.fen[b] += delta;
+}
+
+/**
+ * Adds a node on top of the index.
+
+ * @param node: The node, now the top of the stack.
+
+ * @return: 0 on success, -1 when the index has no room left: it must then
+ * be rebuilt (see idx_rebuild).
+ */
+int idx_push(stack_t *node)
+{
+	size_t b = stack_idx.nblk;
+
+	if (b == 0 || stack_idx.cnt[b - 1] == IDX_BLK)
+	{
+		if (b == stack_idx.cap)
+			return (-1);
+		if (stack_idx.blk[b] == NULL)
+			stack_idx.blk[b] = malloc(IDX_BLK * sizeof(stack_t *));
+		if (stack_idx.blk[b] == NULL)
+			err(4);
+		stack_idx.nblk = ++b;
+	}
+	stack_idx.blk[b - 1][stack_idx.cnt[b - 1]++] = node;
+	fen_add(b - 1, 1);
+	stack_idx.len++;
+	return (0);
+}
+
+/**
+ * Removes nodes from the top of the index.
+
+ * @param n: The number of nodes, at most `len`.
+
+ * Empty blocks at the top are given back, so the top block always holds
+ * the top of the stack.
+ */
+void idx_pop(size_t n)
+{
+	size_t b, k;
+
+	while (stack_idx.nblk > 0 &&
+	       (n > 0 || stack_idx.cnt[stack_idx.nblk - 1] == 0))
+	{
+		b = stack_idx.nblk - 1;
+		k = n < stack_idx.cnt[b] ? n : stack_idx.cnt[b];
+		stack_idx.cnt[b] -= k;
+		fen_add(b, 0 - k);
+		stack_idx.len -= k;
+		n -= k;
+		if (stack_idx.cnt[b] == 0)
+			stack_idx.nblk--;
+	}
+}
+
+/**
+ * Lays out the index for a number of nodes, bottom first, in full blocks.
+
+ * @param n: The number of nodes; the caller fills in their blocks.
+
+ * Room is left for as many nodes again, so the cost of the rebuild is
+ * spread over the pushes and rolls that fill it.
+ */
+void idx_shape(size_t n)
+{
+	stack_idx_t *x = &stack_idx;
+	size_t cap, i, up;
+
+	for (cap = 1; cap < 2 * (n / IDX_BLK + 1); cap *= 2)
+		;
+	if (cap > x->cap)
+	{
+		x->blk = realloc(x->blk, cap * sizeof(*x->blk));
+		x->cnt = realloc(x->cnt, cap * sizeof(*x->cnt));
+		x->fen = realloc(x->fen, (cap + 1) * sizeof(*x->fen));
+		if (x->blk == NULL || x->cnt == NULL || x->fen == NULL)
+			err(4);
+		memset(x->blk + x->cap, 0, (cap - x->cap) * sizeof(*x->blk));
+		x->cap = cap;
+	}
+	memset(x->fen, 0, (x->cap + 1) * sizeof(*x->fen));
+	for (i = 0, x->nblk = 0; i < x->cap; i++)
+	{
+		x->cnt[i] = n > i * IDX_BLK ? n - i * IDX_BLK : 0;
+		x->cnt[i] = x->cnt[i] < IDX_BLK ? x->cnt[i] : IDX_BLK;
+		if (x->cnt[i] > 0)
+			x->nblk++;
+		if (x->cnt[i] > 0 && x->blk[i] == NULL)
+			x->blk[i] = malloc(IDX_BLK * sizeof(stack_t *));
+		if (x->cnt[i] > 0 && x->blk[i] == NULL)
+			err(4);
+		up = i + 1 + ((i + 1) & (0 - (i + 1)));
+		x->fen[i + 1] += x->cnt[i];
+		if (up <= x->cap)
+			x->fen[up] += x->fen[i + 1];
+	}
+	x->len = n;
+}
+
+/**
+ * Removes a node from the middle of the index.
+
+ * @param b: The block of the node.
+
+ * @param i: The position of the node in its block.
+
+ * The rest of the block moves down; the other blocks are not touched.
+ */
+void idx_remove(size_t b, size_t i)
+{
+	memmove(stack_idx.blk[b] + i, stack_idx.blk[b] + i + 1,
+		(stack_idx.cnt[b] - i - 1) * sizeof(stack_t *));
+	stack_idx.cnt[b]--;
+	fen_add(b, (size_t)-1);
+	stack_idx.len--;
+	idx_pop(0);
+}
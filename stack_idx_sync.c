@@ -0,0 +1,178 @@
+#include "monty.h"
+
+/**
+ * Indexes the whole stack again.
+
+ * The index then matches the stack before the current instruction.
+ */
+void idx_rebuild(void)
+{
+	stack_t *node;
+	size_t n = 0, i, k;
+
+	for (node = head; node != NULL; node = node->next)
+		n++;
+	idx_shape(n);
+	for (i = 0, node = head; i < n; i++, node = node->next)
+	{
+		k = n - 1 - i;
+		stack_idx.blk[k / IDX_BLK][k % IDX_BLK] = node;
+	}
+	stack_idx.at = pc;
+}
+
+/**
+ * Tells how an instruction changed the top of the stack.
+
+ * @param c: The instruction, already run.
+
+ * @param pops: Where to store the number of nodes it took off the top.
+
+ * @param pushes: Where to store the number of nodes it left there instead.
+
+ * @return: 0 on success, -1 for an instruction the index cannot follow
+ * (queue regions, rotations, `sort` of the whole stack, ...).
+
+ * The nodes below those are untouched; the ones above may be new nodes or
+ * the same ones with other values, the index takes them again either way.
+ * A negative count stands for an argument: -1 is `n`, -2 is `n2`, -3 is
+ * `n` + 1 and -4 the length of a `range`.
+ */
+static int idx_effect(code_t *c, size_t *pops, size_t *pushes)
+{
+	static const struct
+	{
+		op_func f;
+		int pops;
+		int pushes;
+	} effects[] = {
+		{push_stack, 0, 1}, {pick_nodes, 0, 1}, {roll_nodes, -3, -3},
+		{pop_top, 1, 0}, {add_nodes, 2, 1}, {sub_nodes, 2, 1},
+		{mul_nodes, 2, 1}, {div_nodes, 2, 1}, {mod_nodes, 2, 1},
+		{swap_nodes, 2, 2}, {load_stack, 0, 1}, {store_reg, 1, 0},
+		{push_big_stack, 0, 1}, {print_stack, 0, 0}, {print_top, 0, 0},
+		{print_char, 0, 0}, {print_str, 0, 0}, {nop, 0, 0},
+		{sum_nodes, -1, 1}, {prod_nodes, -1, 1}, {rev_nodes, -1, -1},
+		{sort_nodes, -1, -1}, {addc_nodes, -2, -2}, {mulc_nodes, -2, -2},
+		{range_stack, 0, -4}, {NULL, 0, 0}
+	};
+	long arg[5], po, pu;
+	int i;
+
+	for (i = 0; effects[i].f != NULL && effects[i].f != c->f; i++)
+		;
+	if (effects[i].f == NULL)
+		return (-1);
+	arg[0] = 0;
+	arg[1] = c->n;
+	arg[2] = c->n2;
+	arg[3] = (long)c->n + 1;
+	arg[4] = (long)c->n2 - c->n;
+	arg[4] = (arg[4] < 0 ? -arg[4] : arg[4]) + 1;
+	po = effects[i].pops < 0 ? arg[-effects[i].pops] : effects[i].pops;
+	pu = effects[i].pushes < 0 ? arg[-effects[i].pushes] :
+		effects[i].pushes;
+	if (po < 0 || (po == 0 && effects[i].pops < 0))
+		return (-1);
+	*pops = po;
+	*pushes = pu;
+	return (0);
+}
+
+/**
+ * Brings the index up to date with the stack, before the current
+ * instruction.
+
+ * The instructions run since the index last matched the stack are replayed
+ * on its top: the nodes they took off are dropped and the ones they left
+ * are taken from the top of the stack, at the cost of running them again.
+ * The index is rebuilt when that cannot be done, or would cost more.
+ */
+static void idx_sync(void)
+{
+	stack_idx_t *x = &stack_idx;
+	size_t pops = 0, fresh = 0, po, pu, i;
+	stack_t *node, *top;
+	code_t *c;
+	int ok;
+
+	for (c = x->at; c != NULL && c < pc; c++)
+	{
+		if (idx_effect(c, &po, &pu) == -1)
+			break;
+		pops += po > fresh ? po - fresh : 0;
+		fresh = (po > fresh ? 0 : fresh - po) + pu;
+	}
+	if (c == pc && pops <= x->len && fresh <= x->len - pops)
+	{
+		idx_pop(pops);
+		if (fresh > x->tsize)
+		{
+			x->tmp = realloc(x->tmp, fresh * sizeof(*x->tmp));
+			if (x->tmp == NULL)
+				err(4);
+			x->tsize = fresh;
+		}
+		for (i = 0, node = head; i < fresh && node != NULL; i++)
+		{
+			x->tmp[i] = node;
+			node = node->next;
+		}
+		top = x->len ? x->blk[x->nblk - 1][x->cnt[x->nblk - 1] - 1]
+			: NULL;
+		ok = i == fresh && node == top;
+		while (ok && i > 0)
+			ok = idx_push(x->tmp[--i]) == 0;
+		if (ok)
+		{
+			x->at = pc;
+			return;
+		}
+	}
+	idx_rebuild();
+}
+
+/**
+ * Finds the node at a given depth.
+
+ * @param depth: The depth, 0 being the top of the stack.
+
+ * @param take: 1 to also remove the node from the index, for `roll`.
+
+ * @return: The node, or NULL when the stack is not that deep.
+ */
+stack_t *idx_find(size_t depth, int take)
+{
+	stack_idx_t *x = &stack_idx;
+	size_t b = 0, rem, step;
+	stack_t *node;
+
+	idx_sync();
+	if (depth >= x->len)
+		return (NULL);
+	rem = x->len - 1 - depth;
+	for (step = x->cap; step > 0; step /= 2)
+	{
+		if (b + step <= x->cap && x->fen[b + step] <= rem)
+		{
+			b += step;
+			rem -= x->fen[b];
+		}
+	}
+	node = x->blk[b][rem];
+	if (take)
+		idx_remove(b, rem);
+	return (node);
+}
+
+/**
+ * Records the node a deep `pick` or `roll` left on top of the stack.
+
+ * @param top: The node.
+ */
+void idx_done(stack_t *top)
+{
+	if (idx_push(top) == -1)
+		idx_rebuild();
+	stack_idx.at = pc + 1;
+}
@@ -25,6 +25,8 @@
  * - The specific data type stored within the nodes for clarity.
  * - Any specific rounding behavior employed for the product.
 
+ * On overflow, or when an operand is boxed, the result is computed by
+ * num_arith and promoted to a 64-bit or bignum value as needed.
  */
 void mul_nodes(stack_t **stack, unsigned int line_number)
 {
@@ -34,9 +36,12 @@ void mul_nodes(stack_t **stack, unsigned int line_number)
 		more_err(8, line_number, "mul");
 
 	(*stack) = (*stack)->next;
-	sum = (*stack)->n * (*stack)->prev->n;
-	(*stack)->n = sum;
-	free((*stack)->prev);
+	if (((*stack)->tag | (*stack)->prev->tag) != TAG_INT ||
+	    __builtin_mul_overflow((*stack)->n, (*stack)->prev->n, &sum))
+		num_arith(*stack, (*stack)->prev, '*');
+	else
+		(*stack)->n = sum;
+	free_node((*stack)->prev);
 	(*stack)->prev = NULL;
 }
 
@@ -67,6 +72,8 @@ void mul_nodes(stack_t **stack, unsigned int line_number)
  * - The specific data type stored within the nodes for clarity.
  * - Any specific rounding behavior employed for the modulo.
 
+ * Boxed operands go through num_arith, as does a divisor of -1, which would
+ * trap on INT_MIN.
  */
 
 void mod_nodes(stack_t **stack, unsigned int line_number)
@@ -78,11 +85,17 @@ void mod_nodes(stack_t **stack, unsigned int line_number)
 		more_err(8, line_number, "mod");
 
 
-	if ((*stack)->n == 0)
+	if ((*stack)->tag == TAG_INT && (*stack)->n == 0)
 		more_err(9, line_number);
 	(*stack) = (*stack)->next;
-	sum = (*stack)->n % (*stack)->prev->n;
-	(*stack)->n = sum;
-	free((*stack)->prev);
+	if (((*stack)->tag | (*stack)->prev->tag) != TAG_INT ||
+	    (*stack)->prev->n == -1)
+		num_arith(*stack, (*stack)->prev, '%');
+	else
+	{
+		sum = (*stack)->n % (*stack)->prev->n;
+		(*stack)->n = sum;
+	}
+	free_node((*stack)->prev);
 	(*stack)->prev = NULL;
 }
@@ -0,0 +1,74 @@
+#include "monty.h"
+
+/**
+ * Forgets the index of the stack; the next deep `pick` or `roll` rebuilds
+ * it.
+
+ * Called whenever `head` is replaced by another stack.
+ */
+void idx_reset(void)
+{
+	stack_idx.at = NULL;
+}
+
+/**
+ * Pushes a copy of the element at a given depth on top of the stack.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * `pick 0` copies the top element, `pick 1` the one below it, and so on.
+ * Depths of IDX_MIN or more are found through the index of the stack in
+ * O(log n), so repeated deep picks do not walk the stack each time.
+ */
+void pick_nodes(stack_t **stack, unsigned int line_number)
+{
+	stack_t *node, *copy;
+	int i, deep = pc->n >= IDX_MIN && !pool.spill;
+
+	node = deep ? idx_find(pc->n, 0) : *stack;
+	for (i = 0; !deep && node != NULL && i < pc->n; i++)
+		node = node->next;
+	if (node == NULL)
+		more_err(8, line_number, "pick");
+	copy = create_node(0);
+	num_copy(copy, node);
+	add_to_stack(&copy, line_number);
+	if (deep)
+		idx_done(copy);
+}
+
+/**
+ * Moves the element at a given depth to the top of the stack.
+
+ * @param stack: Pointer to a pointer pointing to the top node of the stack.
+
+ * @param line_number: The line number of the instruction.
+
+ * `roll 1` is `swap`; `roll n` brings up the element `pick n` would copy.
+ * The node is relinked, no value is copied and nothing is allocated. Deep
+ * nodes are found and taken out of the index as in pick_nodes.
+ */
+void roll_nodes(stack_t **stack, unsigned int line_number)
+{
+	stack_t *node;
+	int i, deep = pc->n >= IDX_MIN && !pool.spill;
+
+	node = deep ? idx_find(pc->n, 1) : *stack;
+	for (i = 0; !deep && node != NULL && i < pc->n; i++)
+		node = node->next;
+	if (node == NULL)
+		more_err(8, line_number, "roll");
+	if (node == *stack)
+		return;
+	node->prev->next = node->next;
+	if (node->next != NULL)
+		node->next->prev = node->prev;
+	node->prev = NULL;
+	node->next = *stack;
+	(*stack)->prev = node;
+	*stack = node;
+	if (deep)
+		idx_done(node);
+}
@@ -20,9 +20,9 @@ void print_char(stack_t **stack, unsigned int line_number)
 		string_err(11, line_number);
 
 	ascii = (*stack)->n;
-	if (ascii < 0 || ascii > 127)
+	if ((*stack)->tag != TAG_INT || ascii < 0 || ascii > 127)
 		string_err(10, line_number);
-	printf("%c\n", ascii);
+	fprintf(out_stream, "%c\n", ascii);
 }
 
 /**
@@ -41,23 +41,26 @@ void print_str(stack_t **stack, __attribute__((unused))unsigned int ln)
 {
 	int ascii;
 	stack_t *tmp;
+	size_t i;
 
 	if (stack == NULL || *stack == NULL)
 	{
-		printf("\n");
+		fputc('\n', out_stream);
 		return;
 	}
 
 	tmp = *stack;
-	while (tmp != NULL)
+	for (i = 1; tmp != NULL; i++)
 	{
 		ascii = tmp->n;
-		if (ascii <= 0 || ascii > 127)
+		if (tmp->tag != TAG_INT || ascii <= 0 || ascii > 127)
 			break;
-		printf("%c", ascii);
+		fputc(ascii, out_stream);
 		tmp = tmp->next;
+		if ((i & POOL_WALK) == 0)
+			pool_walk(tmp);
 	}
-	printf("\n");
+	fputc('\n', out_stream);
 }
 
 /**